@@ -0,0 +1,83 @@
+/**
+ * RetroRec - Benchmark Kit (The "Stopwatch")
+ * Plain executables that print a table and assert nothing: synthetic screens (a page of text being typed
+ * into or scrolled), a wall-clock timer and the process CPU time. Numbers are per frame, Release builds only.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace retrorec::bench {
+
+    using Pixels = std::vector<uint8_t>;
+
+    // Glyph grid of the synthetic page: 10 x 18 px cells, 8 x 14 px of ink
+    constexpr int GLYPH_W = 10, LINE_H = 18;
+
+    // One glyph at cell (col, line); the shape follows `code` so neighbouring glyphs differ.
+    inline void DrawGlyph(Pixels& p, int w, int h, int col, int line, uint32_t code) {
+        const int x0 = 8 + col * GLYPH_W, y0 = 8 + line * LINE_H;
+        for (int y = 0; y < 14 && y0 + y < h; y++)
+            for (int x = 0; x < 8 && x0 + x < w; x++) {
+                const bool ink = ((code >> ((x * 3 + y) % 29)) & 1) && (x == 0 || y % 4 != 3);
+                uint8_t* px = p.data() + (static_cast<size_t>(y0 + y) * w + x0 + x) * 4;
+                px[0] = px[1] = px[2] = ink ? 40 : 245; px[3] = 255;
+            }
+    }
+
+    // A light page with `fill` (0..1) of its lines full of text.
+    inline Pixels TextPage(int w, int h, double fill, uint32_t seed = 1) {
+        Pixels p(static_cast<size_t>(w) * h * 4);
+        for (size_t i = 0; i < p.size(); i += 4) { p[i] = p[i + 1] = p[i + 2] = 245; p[i + 3] = 255; }
+        const int cols = (w - 16) / GLYPH_W, lines = (h - 16) / LINE_H;
+        uint32_t s = seed * 2654435761u + 1;
+        for (int l = 0; l < lines; l++) {
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            if ((s % 1000) >= fill * 1000) continue;
+            const int len = static_cast<int>(s % static_cast<uint32_t>(cols));
+            for (int c = 0; c < len; c++) { s ^= s << 13; s ^= s >> 17; s ^= s << 5; if (s % 7) DrawGlyph(p, w, h, c, l, s); }
+        }
+        return p;
+    }
+
+    // Typing: glyph number `n` of a line that wraps onto the next one.
+    inline void TypeNext(Pixels& p, int w, int h, int n) {
+        const int cols = (w - 16) / GLYPH_W;
+        DrawGlyph(p, w, h, n % cols, 4 + (n / cols) % 8, 0x9E3779B9u * static_cast<uint32_t>(n + 1));
+    }
+
+    // Scrolling: the page moves up by `dy` rows; the rows uncovered at the bottom come from `below`.
+    inline void ScrollUp(Pixels& p, int w, int h, int dy, const Pixels& below, int& belowRow) {
+        const size_t stride = static_cast<size_t>(w) * 4;
+        memmove(p.data(), p.data() + dy * stride, (h - dy) * stride);
+        for (int y = h - dy; y < h; y++, belowRow = (belowRow + 1) % h) memcpy(p.data() + y * stride, below.data() + belowRow * stride, stride);
+    }
+
+    // Average wall time of `fn()` over `n` calls, in microseconds.
+    template <class F>
+    double MicrosPerCall(F&& fn, int n) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++) fn(i);
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / n;
+    }
+
+    // CPU time of the whole process (every thread), seconds.
+    inline double ProcessCpuSeconds() {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage u{}; getrusage(RUSAGE_SELF, &u);
+        return u.ru_utime.tv_sec + u.ru_stime.tv_sec + (u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e6;
+#else
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+}
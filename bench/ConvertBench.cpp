@@ -0,0 +1,106 @@
+// BGRA -> YUV420P per frame: the incremental converter (diff, then only the stale blocks of a rotating slot) against a
+// whole-frame conversion, on typing (a glyph per frame) and scrolling (everything moves). With FFmpeg, swscale's
+// whole-frame path is listed for reference. Usage: retrorec_convert_bench [width height frames]
+#include "Bench.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "core/IncrementalConverter.hpp"
+#include "core/TileMap.hpp"
+
+#ifdef RETROREC_BENCH_SWSCALE
+extern "C" {
+#include <libswscale/swscale.h>
+}
+#endif
+
+using namespace retrorec::bench;
+using RetroRec::Core::IncrementalConverter;
+using RetroRec::Core::TileMap;
+
+namespace {
+    struct Planes {
+        int stride[3];
+        std::vector<uint8_t> plane[3];
+        uint8_t* data[3];
+        Planes(int w, int h) {
+            stride[0] = (w + 31) & ~31; stride[1] = stride[2] = ((w / 2) + 31) & ~31;
+            for (int p = 0; p < 3; p++) { plane[p].assign(static_cast<size_t>(stride[p]) * (p ? h / 2 : h), 0); data[p] = plane[p].data(); }
+        }
+        Planes(const Planes&) = delete; // data[] points into the planes
+    };
+
+    // Runs `frames` frames of a workload; `step` changes the screen (not timed), `convert` is timed.
+    double TimedMicros(int frames, Pixels& cur, Pixels& prev, const std::function<void(int)>& step, const std::function<void()>& convert) {
+        double total = 0;
+        for (int i = 0; i < frames; i++) {
+            prev = cur; step(i);
+            auto t0 = std::chrono::steady_clock::now();
+            convert();
+            total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        }
+        return total / frames;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int w = argc > 2 ? atoi(argv[1]) & ~1 : 1920, h = argc > 2 ? atoi(argv[2]) & ~1 : 1080, frames = argc > 3 ? atoi(argv[3]) : 120;
+    const size_t stride = static_cast<size_t>(w) * 4;
+#ifdef RETROREC_SSE2
+    const char* simd = "SSE2";
+#else
+    const char* simd = "scalar";
+#endif
+    printf("BGRA -> YUV420P, %dx%d, %d frames, converter: %s\n", w, h, frames, simd);
+    printf("%-8s %-26s %12s %14s\n", "workload", "path", "us/frame", "blocks/frame");
+
+    const Pixels below = TextPage(w, h, 0.7, 99);
+    for (const std::string workload : { "typing", "scroll" }) {
+        auto fresh = [&] { return TextPage(w, h, 0.7, 7); };
+        int belowRow = 0;
+        std::function<void(int)> step;
+        Pixels cur, prev;
+        auto reset = [&] {
+            cur = fresh(); prev = cur; belowRow = 0;
+            if (workload == "typing") step = [&](int i) { TypeNext(cur, w, h, i); };
+            else step = [&](int) { ScrollUp(cur, w, h, 6, below, belowRow); };
+        };
+
+        // Incremental: what the engine's worker does (diff against the previous frame, 4 slots in rotation)
+        reset();
+        IncrementalConverter conv(w, h, 16);
+        TileMap dirty(w, h, 16);
+        std::vector<std::unique_ptr<Planes>> slots;
+        for (int i = 0; i < 4; i++) slots.push_back(std::make_unique<Planes>(w, h));
+        std::vector<uint64_t> versions(slots.size(), 0);
+        size_t converted = 0;
+        conv.Advance(nullptr);
+        for (size_t s = 0; s < slots.size(); s++) { conv.Update(cur.data(), slots[s]->data, slots[s]->stride, 0); versions[s] = conv.Version(); } // Warm: every slot current
+        int tick = 0;
+        double inc = TimedMicros(frames, cur, prev, step, [&] {
+            dirty.Clear(); dirty.Diff(prev.data(), cur.data()); conv.Advance(&dirty);
+            Planes& slot = *slots[tick % slots.size()];
+            converted += conv.Update(cur.data(), slot.data, slot.stride, versions[tick % slots.size()]);
+            versions[tick % slots.size()] = conv.Version(); tick++;
+        });
+        printf("%-8s %-26s %12.0f %14.1f\n", workload.c_str(), "incremental (diff + stale)", inc, static_cast<double>(converted) / frames);
+
+        // Whole frame through the same converter (what a fresh slot or a full-screen change costs)
+        reset();
+        Planes full(w, h);
+        double whole = TimedMicros(frames, cur, prev, step, [&] { IncrementalConverter::ConvertRect(cur.data(), stride, full.data, full.stride, 0, 0, w, h); });
+        printf("%-8s %-26s %12.0f %14zu\n", workload.c_str(), "whole frame", whole, conv.BlockCount());
+
+#ifdef RETROREC_BENCH_SWSCALE
+        reset();
+        SwsContext* sws = sws_getContext(w, h, AV_PIX_FMT_BGRA, w, h, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
+        double sw = TimedMicros(frames, cur, prev, step, [&] { const uint8_t* src[] = { cur.data() }; int ss[] = { static_cast<int>(stride) }; sws_scale(sws, src, ss, 0, h, full.data, full.stride); });
+        sws_freeContext(sws);
+        printf("%-8s %-26s %12.0f %14zu\n", workload.c_str(), "whole frame (swscale)", sw, conv.BlockCount());
+#endif
+    }
+    return 0;
+}
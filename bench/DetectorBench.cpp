@@ -0,0 +1,70 @@
+// Sensitive text detection per frame: what the capture thread pays (the shared diff, then Submit with the changed tiles
+// or with the whole frame) and what the worker spends scanning, on typing and scrolling.
+// Usage: retrorec_detector_bench [width height frames]
+#include "Bench.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "core/SensitiveDetector.hpp"
+#include "core/TileMap.hpp"
+
+using namespace retrorec::bench;
+using RetroRec::Core::SensitiveCandidate;
+using RetroRec::Core::SensitiveDetector;
+using RetroRec::Core::TileMap;
+
+namespace {
+    struct Costs { double diff = 0, submit = 0, scan = 0; };
+
+    // Feeds `frames` frames of a workload; `withMap` hands the detector the diff, otherwise the whole frame.
+    Costs Run(int w, int h, int frames, const std::function<void(Pixels&, int)>& step, bool withMap) {
+        SensitiveDetector<> detector(w, h, [](const std::vector<SensitiveCandidate>&) {});
+        TileMap changed(w, h, 16); // The engine's block size
+        Pixels cur = TextPage(w, h, 0.7, 7), prev;
+        detector.Submit(cur.data());
+        for (int i = 0; i < 100; i++) { // The first full scan takes many budgets (one per frame): not counted
+            changed.Clear(); detector.Submit(cur.data(), &changed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        }
+        Costs c;
+        for (int i = 0; i < frames; i++) {
+            prev = cur; step(cur, i);
+            auto t0 = std::chrono::steady_clock::now();
+            changed.Clear(); changed.Diff(prev.data(), cur.data());
+            auto t1 = std::chrono::steady_clock::now();
+            detector.Submit(cur.data(), withMap ? &changed : nullptr);
+            auto t2 = std::chrono::steady_clock::now();
+            c.diff += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            c.submit += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            std::this_thread::sleep_for(std::chrono::milliseconds(8)); // Let the scan finish (a 30 fps frame is 33 ms)
+            c.scan += static_cast<double>(detector.LastScanMicros());
+        }
+        c.diff /= frames; c.submit /= frames; c.scan /= frames;
+        return c;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int w = argc > 2 ? atoi(argv[1]) : 1920, h = argc > 2 ? atoi(argv[2]) : 1080, frames = argc > 3 ? atoi(argv[3]) : 120;
+    printf("Sensitive text detection, %dx%d, %d frames, scan budget 2000 us\n", w, h, frames);
+    printf("%-8s %-22s %10s %12s %12s\n", "workload", "submit", "diff us", "submit us", "scan us");
+
+    const Pixels below = TextPage(w, h, 0.7, 99);
+    for (const std::string workload : { "typing", "scroll" }) {
+        int belowRow = 0;
+        std::function<void(Pixels&, int)> step;
+        if (workload == "typing") step = [&](Pixels& p, int i) { TypeNext(p, w, h, i); };
+        else step = [&](Pixels& p, int) { ScrollUp(p, w, h, 6, below, belowRow); };
+        for (bool withMap : { true, false }) {
+            belowRow = 0;
+            const Costs c = Run(w, h, frames, step, withMap);
+            printf("%-8s %-22s %10.0f %12.0f %12.0f\n", workload.c_str(), withMap ? "changed tiles (diff)" : "whole frame", c.diff, c.submit, c.scan);
+        }
+    }
+    printf("diff: once per frame on the capture thread, shared with the converter. scan: worker thread.\n");
+    if (std::thread::hardware_concurrency() < 2) printf("single core: the submit column includes the scan it wakes\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Region-of-interest hints against plain CRF: bytes written and encoder CPU time for one typing workload (a page being
+// typed into, one masked area, a cursor drifting over it), opened with the engine's H.264 settings (openH264Encoder).
+// Rows: CRF 23 as the preset has it, CRF 23 with adaptive quantization alone (what enabling hints switches on), and
+// CRF 23 with hints built the way the engine builds them. One encoder thread, so the CPU time is the encoder's alone.
+// Sizes only: hints move quality toward the cursor and the changed areas on purpose. Needs FFmpeg with libx264.
+// Usage: retrorec_roi_bench [width height frames [preset]]
+#include "Bench.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include "EncoderSink.hpp"
+#include "core/IncrementalConverter.hpp"
+#include "core/MaskKernel.hpp"
+#include "core/TileMap.hpp"
+
+using namespace retrorec;
+using namespace retrorec::bench;
+using RetroRec::Core::IncrementalConverter;
+using RetroRec::Core::MosaicMask;
+using RetroRec::Core::TileMap;
+
+namespace {
+    struct Result { size_t bytes = 0; double cpu = 0; bool ok = false; };
+
+    constexpr int CURSOR_BOX = 96;     // As the engine's buildRegionsOfInterest
+    constexpr size_t MAX_DIRTY_RUNS = 128;
+
+    // Masks first (earlier entries win), then the cursor box, then runs of changed blocks unless most of the frame changed
+    void BuildHints(std::vector<AVRegionOfInterest>& rois, const TileMap& dirty, int w, int h, const int mask[4], int cx, int cy) {
+        auto add = [&](int x, int y, int rw, int rh, AVRational q) {
+            int x0 = (std::max)(x, 0), y0 = (std::max)(y, 0), x1 = (std::min)(x + rw, w), y1 = (std::min)(y + rh, h);
+            if (x1 <= x0 || y1 <= y0) return;
+            AVRegionOfInterest r{}; r.self_size = sizeof(AVRegionOfInterest); r.left = x0; r.top = y0; r.right = x1; r.bottom = y1; r.qoffset = q;
+            rois.push_back(r);
+        };
+        rois.clear();
+        add(mask[0], mask[1], mask[2], mask[3], { 3, 5 });
+        add(cx - CURSOR_BOX / 2, cy - CURSOR_BOX / 2, CURSOR_BOX, CURSOR_BOX, { -1, 5 });
+        const size_t total = static_cast<size_t>(dirty.Cols()) * dirty.Rows(), ts = dirty.TileSize();
+        if (dirty.Count() == 0 || dirty.Count() > total / 2) return;
+        size_t runs = 0;
+        for (int r = 0; r < dirty.Rows() && runs < MAX_DIRTY_RUNS; r++)
+            for (int c = 0; c < dirty.Cols(); c++) {
+                if (!dirty.IsSet(c, r)) continue;
+                int c1 = c; while (c1 + 1 < dirty.Cols() && dirty.IsSet(c1 + 1, r)) c1++;
+                add(c * static_cast<int>(ts), r * static_cast<int>(ts), (c1 - c + 1) * static_cast<int>(ts), static_cast<int>(ts), { -1, 10 }); runs++;
+                c = c1;
+            }
+    }
+
+    size_t Drain(AVCodecContext* ctx, AVPacket* pkt) {
+        size_t bytes = 0;
+        while (avcodec_receive_packet(ctx, pkt) == 0) { bytes += static_cast<size_t>(pkt->size); av_packet_unref(pkt); }
+        return bytes;
+    }
+
+    Result Encode(const Rendition& rc, bool aq, bool hints, int frames) {
+        const int w = rc.width, h = rc.height;
+        Rendition open = rc; open.roi_hints = aq; // openH264Encoder switches adaptive quantization on for hinted renditions
+        AVCodecContext* ctx = openH264Encoder(open, 1);
+        if (!ctx) return {};
+        AVPacket* pkt = av_packet_alloc();
+        std::vector<AVFrameRef> slots;
+        std::vector<AVRegionOfInterest> rois;
+        IncrementalConverter conv(w, h, 16);
+        TileMap dirty(w, h, 16);
+        const int mask[4] = { w / 2, h / 8, w / 4, h / 6 };
+        Pixels cur = TextPage(w, h, 0.7, 7), prev;
+        MosaicMask<>::Apply(cur.data(), w, h, mask[0], mask[1], mask[2], mask[3]);
+
+        Result res; res.ok = true;
+        for (int i = 0; i < frames; i++) {
+            prev = cur; TypeNext(cur, w, h, i);
+            MosaicMask<>::Apply(cur.data(), w, h, mask[0], mask[1], mask[2], mask[3]); // A live mask: every frame
+            dirty.Clear(); dirty.Diff(prev.data(), cur.data());
+            AVFrameRef yuv = acquireYuvSlot(slots, w, h);
+            IncrementalConverter::ConvertRect(cur.data(), static_cast<size_t>(w) * 4, yuv->data, yuv->linesize, 0, 0, w, h);
+            yuv->pts = static_cast<int64_t>(i) * 1000000 / rc.fps; // ENCODER_TIME_BASE
+            if (hints) {
+                const int cx = 200 + (i * 7) % (w / 2), cy = 120 + (i * 3) % (h / 2);
+                BuildHints(rois, dirty, w, h, mask, cx, cy);
+                setRegionsOfInterest(yuv.get(), rois.data(), rois.size());
+            }
+            const double t0 = ProcessCpuSeconds();
+            if (avcodec_send_frame(ctx, yuv.get()) < 0) { res.ok = false; break; }
+            res.bytes += Drain(ctx, pkt);
+            res.cpu += ProcessCpuSeconds() - t0;
+        }
+        const double t0 = ProcessCpuSeconds();
+        avcodec_send_frame(ctx, nullptr);
+        res.bytes += Drain(ctx, pkt);
+        res.cpu += ProcessCpuSeconds() - t0;
+        av_packet_free(&pkt);
+        avcodec_free_context(&ctx);
+        return res;
+    }
+}
+
+int main(int argc, char** argv) {
+    Rendition rc;
+    rc.width = argc > 2 ? atoi(argv[1]) & ~1 : 1920; rc.height = argc > 2 ? atoi(argv[2]) & ~1 : 1080;
+    const int frames = argc > 3 ? atoi(argv[3]) : 300;
+    if (argc > 4) rc.preset = argv[4];
+    rc.crf = 23;
+    printf("H.264 CRF %d, preset %s, %dx%d, %d frames of typing at %d fps, 1 encoder thread\n", rc.crf, rc.preset.c_str(), rc.width, rc.height, frames, rc.fps);
+    printf("%-28s %12s %12s %14s\n", "encoder", "kbit/s", "vs plain", "encode ms/frame");
+
+    const struct { const char* name; bool aq, hints; } rows[] = { { "CRF 23", false, false }, { "CRF 23 + aq-mode", true, false }, { "CRF 23 + aq-mode + hints", true, true } };
+    double plain = 0;
+    for (const auto& row : rows) {
+        const Result r = Encode(rc, row.aq, row.hints, frames);
+        if (!r.ok) { printf("%-28s encoder failed (libx264 missing?)\n", row.name); continue; }
+        const double kbps = r.bytes * 8.0 / (static_cast<double>(frames) / rc.fps) / 1000.0;
+        if (&row == rows) plain = kbps;
+        printf("%-28s %12.0f %11.0f%% %14.2f\n", row.name, kbps, plain > 0 ? 100.0 * kbps / plain : 0.0, r.cpu * 1000.0 / frames);
+    }
+    return 0;
+}
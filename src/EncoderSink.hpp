@@ -0,0 +1,507 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+#include <libavutil/opt.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+}
+
+namespace retrorec {
+
+    using AVFrameRef = std::shared_ptr<AVFrame>;
+
+    // Rotating encoder input frames: hands out one that nobody (rendition queue, encoder) references any more,
+    // so writing into it never triggers the copy inside av_frame_make_writable. Grows only while all are in flight, up to
+    // `max_slots`: past that the caller gets nullptr and drops the frame (a lagging encoder must not eat the memory budget).
+    inline AVFrameRef acquireYuvSlot(std::vector<AVFrameRef>& slots, int w, int h, size_t* index = nullptr, size_t max_slots = SIZE_MAX) {
+        for (size_t i = 0; i < slots.size(); i++) if (slots[i].use_count() == 1 && av_frame_is_writable(slots[i].get())) { std::atomic_thread_fence(std::memory_order_acquire); if (index) *index = i; return slots[i]; }
+        if (slots.size() >= max_slots) return nullptr;
+        AVFrameRef s(av_frame_alloc(), [](AVFrame* f) { av_frame_free(&f); });
+        s->format = AV_PIX_FMT_YUV420P; s->width = w; s->height = h; av_frame_get_buffer(s.get(), 32);
+        if (index) *index = slots.size();
+        slots.push_back(s);
+        return s;
+    }
+
+    // Sets the frame's region-of-interest hints. The side data a recycled slot still carries is rewritten in place when nobody
+    // else references it any more (the encoder let go), so steady state allocates nothing; a new buffer gets room to grow.
+    // No hints = one neutral whole-frame entry (qoffset 0) instead of removing the buffer.
+    inline bool setRegionsOfInterest(AVFrame* f, const AVRegionOfInterest* rois, size_t n) {
+        AVRegionOfInterest neutral{};
+        if (n == 0) { neutral.self_size = sizeof(AVRegionOfInterest); neutral.right = f->width; neutral.bottom = f->height; neutral.qoffset = { 0, 1 }; rois = &neutral; n = 1; }
+        const size_t bytes = n * sizeof(AVRegionOfInterest);
+        AVFrameSideData* sd = av_frame_get_side_data(f, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+        if (sd && (!sd->buf || !av_buffer_is_writable(sd->buf) || (size_t)sd->buf->size < bytes)) { av_frame_remove_side_data(f, AV_FRAME_DATA_REGIONS_OF_INTEREST); sd = nullptr; }
+        if (!sd) {
+            AVBufferRef* buf = av_buffer_alloc((std::max)(bytes * 2, 64 * sizeof(AVRegionOfInterest)));
+            if (!buf) return false;
+            sd = av_frame_new_side_data_from_buf(f, AV_FRAME_DATA_REGIONS_OF_INTEREST, buf);
+            if (!sd) { av_buffer_unref(&buf); return false; }
+        }
+        memcpy(sd->data, rois, bytes); sd->size = bytes;
+        return true;
+    }
+
+    // FilePerSource: Rec_<time>_<source>.mp4 for every source. MultiTrack: one Rec_<time>.mp4 with one video track per source.
+    enum class OutputLayout { FilePerSource, MultiTrack };
+
+    // One output size of the same capture (e.g. full-res archive + 720p share copy).
+    // width/height 0 = source size (one of them 0 = keep aspect). Empty file = Rec_<time>[_<w>x<h>[_<n>]].mp4, where <n> (the
+    // rendition's index) only appears when two renditions come out the same size. Explicit files must differ from each other.
+    struct Rendition {
+        int width = 0, height = 0, fps = 30, crf = 23;
+        std::string preset = "ultrafast";
+        std::string file;
+        bool roi_hints = true; // Region-of-interest QP offsets: masks get almost no bits, cursor and changed areas get more.
+                               // Switches x264's adaptive quantization on (ultrafast leaves it off); bench/RoiBench.cpp measures the cost
+        int downscale = 1;     // Divides the resolved size (set by the load governor)
+
+        bool operator==(const Rendition& o) const { return width == o.width && height == o.height && fps == o.fps && crf == o.crf && preset == o.preset && file == o.file && roi_hints == o.roi_hints && downscale == o.downscale; }
+        bool operator!=(const Rendition& o) const { return !(*this == o); }
+    };
+
+    // What a sink gets to know about each source (index = position in the engine's source list).
+    struct SinkSource {
+        std::string name;
+        int width = 0, height = 0;
+    };
+
+    // A video track the sink wrote (kept until the next recording starts): what a retro patch needs to re-encode it.
+    struct WrittenTrack {
+        std::string path;
+        int stream_index = -1;
+        size_t source = 0;
+        Rendition cfg; // Resolved
+        int threads = 1; // Encoder threads: x264's slices with zerolatency, part of how the track was encoded
+    };
+
+    // Encoder time base: the engine's pts (microseconds since the start of the file) go in unchanged, so the frame every
+    // rendition shares is handed to the encoder as is. The rate still follows the rendition's fps (framerate).
+    constexpr AVRational ENCODER_TIME_BASE{ 1, 1000000 };
+
+    // H.264 encoder for one rendition. Retro patches re-open it with the same settings, so both go through here.
+    inline AVCodecContext* openH264Encoder(const Rendition& rc, int threads) {
+        const AVCodec* vc = avcodec_find_encoder(AV_CODEC_ID_H264);
+        AVCodecContext* ctx = avcodec_alloc_context3(vc);
+        if (!ctx) return nullptr;
+        ctx->width = rc.width; ctx->height = rc.height; ctx->time_base = ENCODER_TIME_BASE; ctx->framerate = { rc.fps, 1 }; ctx->pix_fmt = AV_PIX_FMT_YUV420P; ctx->thread_count = threads;
+        av_opt_set(ctx->priv_data, "preset", rc.preset.c_str(), 0);
+        av_opt_set(ctx->priv_data, "crf", std::to_string(rc.crf).c_str(), 0);
+        av_opt_set(ctx->priv_data, "tune", "zerolatency", 0);
+        // x264 applies region-of-interest offsets through adaptive quantization, which the ultrafast preset switches off
+        if (rc.roi_hints) av_opt_set(ctx->priv_data, "aq-mode", "variance", 0);
+        if (avcodec_open2(ctx, vc, nullptr) < 0) avcodec_free_context(&ctx);
+        return ctx;
+    }
+
+    struct OutputFile {
+        std::string path;
+        AVFormatContext* fmt_ctx = nullptr;
+        AVStream* audio_stream = nullptr; // Every rendition file carries the audio track
+        std::mutex mux_mutex; // av_interleaved_write_frame is not thread-safe; every encoder thread of this file goes through here
+    };
+
+    // One rendition of one source. Fed with already-masked full-res YUV frames, downscales and encodes on its own thread.
+    struct RenditionEncoder {
+        Rendition cfg; // Resolved: width/height are the encoded size
+        OutputFile* output = nullptr;
+        AVCodecContext* video_ctx = nullptr;
+        AVStream* video_stream = nullptr;
+        SwsContext* scale_ctx = nullptr; // Only for renditions smaller than the source
+        std::vector<AVFrameRef> scaled_slots; // At most MAX_SCALED_SLOTS: x264 copies its input, so one is normally enough
+        std::vector<AVRegionOfInterest> scaled_rois; // The source frame's hints rescaled to this rendition
+        AVFrame* input = nullptr;  // Only when this rendition must drop hints the shared source frame carries
+        AVPacket* packet = nullptr; // Reused for every frame
+        int threads = 1;
+        int64_t last_pts = -1; // Last fps slot encoded
+        int crf_offset = 0; // Applied to the open encoder (worker thread only)
+
+        // Load (read by the capture thread)
+        std::atomic<int64_t> busy_us{0};
+        int64_t sampled_busy_us = 0;
+
+        std::thread worker;
+        std::mutex queue_mutex;
+        std::condition_variable wake;
+        std::vector<AVFrameRef> queue, batch; // Swapped, never reallocated in steady state
+        bool finish = false;
+    };
+
+    /**
+     * Sink policy of BasicRecorderEngine. A sink is prepared (encoders open) ahead of time, started on Rec,
+     * fed with one masked YUV420P frame per source and capture tick (pts = microseconds since the start of the file,
+     * optional region-of-interest side data), and finished on Stop. writtenTracks() tells retro patches what to rewrite.
+     * encodeLoad() / queueDepth() / droppedFrames() / setQualityOffset() let the load governor watch and relieve the encoders.
+     *
+     * FFmpegSink: every rendition of every source gets an H.264 encoder on its own thread; files and tracks follow the OutputLayout.
+     */
+    class FFmpegSink {
+        std::vector<SinkSource> sources;
+        std::vector<Rendition> prepared; // As requested; the encoders hold the resolved copies
+        std::vector<std::vector<std::unique_ptr<RenditionEncoder>>> encoders; // [source][rendition]
+        std::vector<std::unique_ptr<OutputFile>> outputs;
+        std::vector<WrittenTrack> written;
+        bool roi_hints = false; // Any rendition wants them
+
+        AVCodecContext* audio_ctx = nullptr;
+        AVFrame* audio_frame = nullptr;
+        AVPacket* audio_packet = nullptr;
+        AVPacket* audio_copy = nullptr;
+        int64_t audio_samples_written = 0;
+
+        std::chrono::steady_clock::time_point start_click;
+        std::atomic<bool> first_write_logged{false};
+        std::atomic<int64_t> start_latency_us{0};
+
+        std::atomic<int> quality_offset{0};
+        std::chrono::steady_clock::time_point load_sampled = std::chrono::steady_clock::now();
+        std::atomic<int64_t> dropped{0}; // Frames a rendition skipped for want of a scaled slot
+
+        static constexpr size_t MAX_SCALED_SLOTS = 2;
+
+    public:
+        ~FFmpegSink() { release(); }
+
+        // Opens every encoder (video per source and rendition, audio). No renditions = one full-res rendition with the default settings.
+        // False (everything released) if a video encoder cannot be opened; audio is optional.
+        bool prepare(const std::vector<SinkSource>& srcs, const std::vector<Rendition>& renditions, int max_fps) {
+            release();
+            if (srcs.empty()) return false;
+            sources = srcs;
+            prepared = renditions.empty() ? std::vector<Rendition>{ Rendition{} } : renditions;
+            for (size_t ri = 0; ri < prepared.size(); ri++)
+                for (size_t rj = 0; rj < ri; rj++)
+                    if (!prepared[ri].file.empty() && fileBase(prepared[ri].file) == fileBase(prepared[rj].file)) {
+                        std::cout << "[Encoder] Renditions " << rj << " and " << ri << " both write " << prepared[ri].file << std::endl;
+                        release();
+                        return false;
+                    }
+
+            // Split the cores between all encoders, weighted by how many pixels each one has to push
+            std::vector<std::vector<Rendition>> resolved(sources.size());
+            double total_px = 0;
+            for (size_t i = 0; i < sources.size(); i++) for (const auto& r : prepared) { resolved[i].push_back(resolveRendition(r, sources[i], max_fps)); total_px += (double)resolved[i].back().width * resolved[i].back().height; }
+            int cores = (std::max)(1, (int)std::thread::hardware_concurrency());
+            encoders.resize(sources.size());
+            for (size_t ri = 0; ri < prepared.size(); ri++) {
+                for (size_t si = 0; si < sources.size(); si++) {
+                    const Rendition& rc = resolved[si][ri];
+                    int threads = (std::max)(1, (int)(cores * ((double)rc.width * rc.height / total_px) + 0.5));
+                    encoders[si].push_back(openRenditionEncoder(sources[si], rc, threads));
+                    if (!encoders[si].back()->video_ctx) {
+                        // No encoder (no libx264, or it refused the settings): nothing could be recorded, so arm / Rec fail here
+                        std::cout << "[Encoder] Cannot open H.264 for " << sources[si].name << " (" << rc.width << "x" << rc.height << ", preset " << rc.preset << ")" << std::endl;
+                        release();
+                        return false;
+                    }
+                }
+            }
+
+            const AVCodec* ac = avcodec_find_encoder(AV_CODEC_ID_AAC);
+            audio_ctx = avcodec_alloc_context3(ac);
+            audio_ctx->sample_fmt = AV_SAMPLE_FMT_FLTP; audio_ctx->bit_rate = 128000; audio_ctx->sample_rate = 48000;
+#if LIBAVCODEC_VERSION_MAJOR >= 60
+            AVChannelLayout cl; av_channel_layout_default(&cl, 2); audio_ctx->ch_layout = cl;
+#else
+            audio_ctx->channels = 2; audio_ctx->channel_layout = AV_CH_LAYOUT_STEREO;
+#endif
+            if (avcodec_open2(audio_ctx, ac, nullptr) >= 0) {
+                audio_packet = av_packet_alloc(); audio_copy = av_packet_alloc();
+                audio_frame = av_frame_alloc(); audio_frame->nb_samples = audio_ctx->frame_size; audio_frame->format = audio_ctx->sample_fmt;
+#if LIBAVCODEC_VERSION_MAJOR >= 60
+                av_channel_layout_copy(&audio_frame->ch_layout, &audio_ctx->ch_layout);
+#else
+                audio_frame->channels = 2; audio_frame->channel_layout = AV_CH_LAYOUT_STEREO;
+#endif
+                av_frame_get_buffer(audio_frame, 0);
+            } else avcodec_free_context(&audio_ctx);
+            return true;
+        }
+
+        void release() {
+            for (auto& per_source : encoders)
+                for (auto& re : per_source) { avcodec_free_context(&re->video_ctx); av_frame_free(&re->input); av_packet_free(&re->packet); sws_freeContext(re->scale_ctx); }
+            encoders.clear(); prepared.clear(); sources.clear(); roi_hints = false;
+            avcodec_free_context(&audio_ctx); av_frame_free(&audio_frame); av_packet_free(&audio_packet); av_packet_free(&audio_copy);
+        }
+
+        const std::vector<Rendition>& renditions() const { return prepared; }
+        bool wantsRegionsOfInterest() const { return roi_hints; }
+        // Video tracks of the last recording (complete once finish() returned)
+        const std::vector<WrittenTrack>& writtenTracks() const { return written; }
+
+        // Creates the files and starts one thread per encoder. The file starts `audio_offset_us` (the pre-roll) before the click;
+        // audio only exists from the click on, so it starts that far in. False (no files left, encoders still open) if a file cannot be written.
+        bool start(OutputLayout layout, std::chrono::steady_clock::time_point click, int64_t audio_offset_us) {
+            if (encoders.empty()) return false;
+            char stamp[64]; time_t t = time(0); tm l;
+#ifdef _WIN32
+            localtime_s(&l, &t);
+#else
+            localtime_r(&t, &l);
+#endif
+            strftime(stamp, 64, "Rec_%Y%m%d_%H%M%S", &l);
+            bool per_source = layout == OutputLayout::FilePerSource && sources.size() > 1;
+
+            std::vector<std::string> bases;
+            for (size_t ri = 0; ri < prepared.size(); ri++) {
+                const Rendition& first = encoders[0][ri]->cfg;
+                bases.push_back(prepared[ri].file.empty() ? std::string(stamp) + (ri > 0 ? "_" + std::to_string(first.width) + "x" + std::to_string(first.height) : "") : fileBase(prepared[ri].file));
+            }
+            const std::vector<std::string> derived = bases; // Same size, same derived name: those also get their index
+            for (size_t ri = 1; ri < prepared.size(); ri++)
+                if (prepared[ri].file.empty() && std::count(derived.begin(), derived.end(), derived[ri]) > 1) bases[ri] += "_" + std::to_string(ri);
+
+            std::vector<OutputFile*> audio_outputs; // Audio follows the first source
+            for (size_t ri = 0; ri < prepared.size(); ri++) {
+                const std::string& base = bases[ri];
+                OutputFile* shared = nullptr;
+                for (size_t si = 0; si < sources.size(); si++) {
+                    OutputFile* of = shared;
+                    if (!of) {
+                        auto nf = std::make_unique<OutputFile>();
+                        nf->path = base + (per_source ? "_" + sources[si].name : "") + ".mp4";
+                        if (avformat_alloc_output_context2(&nf->fmt_ctx, nullptr, nullptr, nf->path.c_str()) < 0 || !nf->fmt_ctx) { abortStart("create", nf->path); return false; }
+                        of = nf.get(); outputs.push_back(std::move(nf));
+                        if (!per_source) shared = of;
+                        if (si == 0) audio_outputs.push_back(of);
+                    }
+                    attachOutput(sources[si], *encoders[si][ri], of);
+                }
+            }
+            written.clear();
+            for (size_t si = 0; si < sources.size(); si++) for (auto& re : encoders[si]) written.push_back({ re->output->path, re->video_stream->index, si, re->cfg, re->threads });
+            if (audio_ctx) {
+                for (OutputFile* of : audio_outputs) {
+                    of->audio_stream = avformat_new_stream(of->fmt_ctx, audio_ctx->codec);
+                    avcodec_parameters_from_context(of->audio_stream->codecpar, audio_ctx);
+                    of->audio_stream->time_base = {1, 48000};
+                }
+            }
+            for (auto& of : outputs) {
+                if (!(of->fmt_ctx->oformat->flags & AVFMT_NOFILE) && avio_open(&of->fmt_ctx->pb, of->path.c_str(), AVIO_FLAG_WRITE) < 0) { abortStart("open", of->path); return false; }
+                if (avformat_write_header(of->fmt_ctx, nullptr) < 0) { abortStart("write the header of", of->path); return false; }
+            }
+            for (auto& per_source : encoders) for (auto& re : per_source) { RenditionEncoder* raw = re.get(); re->worker = std::thread([this, raw] { runRendition(*raw); }); }
+            audio_samples_written = audio_offset_us * 48000 / 1000000;
+            start_click = click; first_write_logged = false;
+            return true;
+        }
+
+        // Source worker thread: hands the (shared, read-only from here on) frame to every rendition of that source.
+        void push(size_t source, const AVFrameRef& yuv) {
+            for (auto& re : encoders[source]) {
+                { std::lock_guard<std::mutex> l(re->queue_mutex); re->queue.push_back(yuv); }
+                re->wake.notify_one();
+            }
+        }
+
+        // Capture thread, once per tick while recording. The loopback PCM is not mixed in yet: the track carries silence at the right timing.
+        void writeAudio(const std::vector<uint8_t>& /*pcm*/) {
+            if (!audio_ctx || !audio_frame) return;
+            av_frame_make_writable(audio_frame); audio_frame->pts = audio_samples_written; audio_samples_written += audio_frame->nb_samples;
+            int nch = 2;
+#if LIBAVCODEC_VERSION_MAJOR >= 60
+            nch = audio_ctx->ch_layout.nb_channels;
+#else
+            nch = audio_ctx->channels;
+#endif
+            for (int i=0; i<audio_frame->nb_samples; i++) for (int c=0; c<nch; c++) ((float*)audio_frame->data[c])[i] = 0.0f;
+            avcodec_send_frame(audio_ctx, audio_frame); AVPacket* ap = audio_packet; AVPacket* cp = audio_copy;
+            while (avcodec_receive_packet(audio_ctx, ap) == 0) {
+                for (auto& of : outputs) {
+                    if (!of->audio_stream) continue;
+                    av_packet_ref(cp, ap); av_packet_rescale_ts(cp, audio_ctx->time_base, of->audio_stream->time_base); cp->stream_index = of->audio_stream->index;
+                    std::lock_guard<std::mutex> ml(of->mux_mutex); av_interleaved_write_frame(of->fmt_ctx, cp); av_packet_unref(cp);
+                }
+                av_packet_unref(ap);
+            }
+        }
+
+        // Rendition threads flush their encoders, then the trailers go out. Flushed encoders cannot take new frames: prepare again.
+        void finish() {
+            for (auto& per_source : encoders) for (auto& re : per_source) { { std::lock_guard<std::mutex> l(re->queue_mutex); re->finish = true; } re->wake.notify_one(); if (re->worker.joinable()) re->worker.join(); }
+            for (auto& of : outputs) { av_write_trailer(of->fmt_ctx); if (!(of->fmt_ctx->oformat->flags & AVFMT_NOFILE)) avio_closep(&of->fmt_ctx->pb); avformat_free_context(of->fmt_ctx); }
+            outputs.clear();
+        }
+
+        // Click-to-first-packet time of the last recording (0 until the first packet was written).
+        std::chrono::microseconds startLatency() const { return std::chrono::microseconds(start_latency_us.load()); }
+
+        // Share of the time since the previous call the busiest encoder thread spent encoding. One caller (the capture thread).
+        double encodeLoad() {
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(now - load_sampled).count();
+            load_sampled = now;
+            double load = 0;
+            for (auto& per_source : encoders) for (auto& re : per_source) {
+                int64_t busy = re->busy_us.load();
+                if (elapsed > 0) load = (std::max)(load, (busy - re->sampled_busy_us) / elapsed);
+                re->sampled_busy_us = busy;
+            }
+            return load;
+        }
+        int queueDepth() {
+            size_t depth = 0;
+            for (auto& per_source : encoders) for (auto& re : per_source) { std::lock_guard<std::mutex> l(re->queue_mutex); depth = (std::max)(depth, re->queue.size()); }
+            return (int)depth;
+        }
+        // Frames the renditions dropped (no free scaled slot) since the sink was created
+        int64_t droppedFrames() const { return dropped; }
+        // Added to every rendition's CRF from the next frame on (x264 reconfigures rate control mid-stream; preset and size are fixed).
+        void setQualityOffset(int crf_delta) { quality_offset = crf_delta; }
+
+    private:
+        static Rendition resolveRendition(Rendition r, const SinkSource& src, int max_fps) {
+            int sw = src.width, sh = src.height;
+            if (r.width <= 0 && r.height <= 0) { r.width = sw; r.height = sh; }
+            else if (r.height <= 0) r.height = (int)((int64_t)r.width * sh / sw);
+            else if (r.width <= 0) r.width = (int)((int64_t)r.height * sw / sh);
+            if (r.downscale > 1) { r.width /= r.downscale; r.height /= r.downscale; }
+            r.width = (std::min)(r.width, sw) & ~1; r.height = (std::min)(r.height, sh) & ~1;
+            r.fps = (std::max)(1, (std::min)(r.fps, max_fps));
+            return r;
+        }
+
+        static std::string fileBase(const std::string& file) { return file.substr(0, file.rfind(".mp4")); }
+
+        // Undoes a start() that could not create its files. The encoders have not seen a frame, so the next start() can use them.
+        void abortStart(const char* what, std::string path) {
+            std::cout << "[Encoder] Cannot " << what << " " << path << std::endl;
+            for (auto& of : outputs) {
+                bool opened = of->fmt_ctx->pb != nullptr;
+                if (!(of->fmt_ctx->oformat->flags & AVFMT_NOFILE)) avio_closep(&of->fmt_ctx->pb);
+                avformat_free_context(of->fmt_ctx);
+                if (opened) std::remove(of->path.c_str()); // Header only, or not even that
+            }
+            outputs.clear(); written.clear();
+            for (auto& per_source : encoders) for (auto& re : per_source) { re->output = nullptr; re->video_stream = nullptr; }
+        }
+
+        std::unique_ptr<RenditionEncoder> openRenditionEncoder(const SinkSource& src, const Rendition& rc, int threads) {
+            int w = src.width, h = src.height;
+            auto re = std::make_unique<RenditionEncoder>();
+            re->cfg = rc; re->threads = threads;
+            re->video_ctx = openH264Encoder(rc, threads); // nullptr: prepare() gives up
+            if (rc.roi_hints) roi_hints = true;
+            if (rc.width != w || rc.height != h) re->scale_ctx = sws_getContext(w, h, AV_PIX_FMT_YUV420P, rc.width, rc.height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
+            re->input = av_frame_alloc(); re->packet = av_packet_alloc();
+            re->last_pts = -1; re->crf_offset = 0;
+            return re;
+        }
+
+        // Adds the (already open) encoder's track to a new output file.
+        void attachOutput(const SinkSource& src, RenditionEncoder& re, OutputFile* of) {
+            re.output = of;
+            re.video_stream = avformat_new_stream(of->fmt_ctx, re.video_ctx->codec);
+            avcodec_parameters_from_context(re.video_stream->codecpar, re.video_ctx);
+            re.video_stream->time_base = { 1, 90000 }; // The usual MP4 video timescale; writePackets rescales from ENCODER_TIME_BASE
+            av_dict_set(&re.video_stream->metadata, "title", src.name.c_str(), 0);
+        }
+
+        void writePackets(RenditionEncoder& re) {
+            AVPacket* p = re.packet;
+            std::lock_guard<std::mutex> ml(re.output->mux_mutex);
+            while (avcodec_receive_packet(re.video_ctx, p) == 0) {
+                if (!first_write_logged.exchange(true)) start_latency_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_click).count();
+                av_packet_rescale_ts(p, re.video_ctx->time_base, re.video_stream->time_base); p->stream_index = re.video_stream->index; av_interleaved_write_frame(re.output->fmt_ctx, p); av_packet_unref(p);
+            }
+        }
+
+        // The shared source frame (or this rendition's own scaled slot) goes to the encoder as is: its pts are already in
+        // ENCODER_TIME_BASE. Only a rendition without hints fed a frame with hints needs a reference of its own to drop them.
+        void encodeAndWrite(RenditionEncoder& re, const AVFrame* yuv) {
+            int64_t slot = yuv->pts * re.cfg.fps / 1000000;
+            if (slot <= re.last_pts) return; // Lower fps renditions skip frames landing in an already filled slot
+            re.last_pts = slot;
+            const AVFrameSideData* hints = av_frame_get_side_data(yuv, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+            const AVFrame* send = yuv;
+            AVFrameRef scaled;
+            if (re.scale_ctx) {
+                scaled = acquireYuvSlot(re.scaled_slots, re.cfg.width, re.cfg.height, nullptr, MAX_SCALED_SLOTS);
+                if (!scaled) { dropped++; re.last_pts = slot - 1; return; } // Every slot still with the encoder: skip this one, the next frame takes the fps slot
+                sws_scale(re.scale_ctx, yuv->data, yuv->linesize, 0, yuv->height, scaled->data, scaled->linesize);
+                scaled->pts = yuv->pts;
+                if (re.cfg.roi_hints && hints) {
+                    // The source frame's hints are shared with the other renditions; this rendition's slot gets a rescaled copy
+                    const AVRegionOfInterest* in = (const AVRegionOfInterest*)hints->data;
+                    const int64_t sw = yuv->width, sh = yuv->height, dw = re.cfg.width, dh = re.cfg.height;
+                    re.scaled_rois.assign(in, in + hints->size / sizeof(AVRegionOfInterest));
+                    for (auto& r : re.scaled_rois) {
+                        r.left = (int)(r.left * dw / sw); r.right = (int)((r.right * dw + sw - 1) / sw);
+                        r.top = (int)(r.top * dh / sh); r.bottom = (int)((r.bottom * dh + sh - 1) / sh);
+                    }
+                    setRegionsOfInterest(scaled.get(), re.scaled_rois.data(), re.scaled_rois.size());
+                } else av_frame_remove_side_data(scaled.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST);
+                send = scaled.get();
+            } else if (hints && !re.cfg.roi_hints) {
+                av_frame_ref(re.input, yuv); av_frame_remove_side_data(re.input, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+                send = re.input;
+            }
+            if (int q = quality_offset.load(); q != re.crf_offset) { av_opt_set(re.video_ctx->priv_data, "crf", std::to_string(re.cfg.crf + q).c_str(), 0); re.crf_offset = q; }
+            avcodec_send_frame(re.video_ctx, send); av_frame_unref(re.input);
+            writePackets(re);
+        }
+
+        // Per-rendition worker: downscale (if needed) and encode, in parallel with the other renditions.
+        void runRendition(RenditionEncoder& re) {
+            for (;;) {
+                bool finish;
+                {
+                    std::unique_lock<std::mutex> l(re.queue_mutex);
+                    re.wake.wait(l, [&] { return re.finish || !re.queue.empty(); });
+                    re.batch.swap(re.queue); finish = re.finish;
+                }
+                auto busy_from = std::chrono::steady_clock::now();
+                for (auto& f : re.batch) encodeAndWrite(re, f.get());
+                re.busy_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - busy_from).count();
+                re.batch.clear();
+                if (finish) { avcodec_send_frame(re.video_ctx, nullptr); writePackets(re); return; }
+            }
+        }
+    };
+
+    // Sink that drops every frame: profiles capture, masking and conversion without paying for encoding.
+    class NullSink {
+        std::vector<Rendition> prepared;
+        std::atomic<uint64_t> received{0};
+
+    public:
+        bool prepare(const std::vector<SinkSource>& srcs, const std::vector<Rendition>& renditions, int) {
+            prepared = renditions.empty() ? std::vector<Rendition>{ Rendition{} } : renditions;
+            return !srcs.empty();
+        }
+        void release() { prepared.clear(); }
+        const std::vector<Rendition>& renditions() const { return prepared; }
+        bool wantsRegionsOfInterest() const { return false; }
+        const std::vector<WrittenTrack>& writtenTracks() const { static const std::vector<WrittenTrack> none; return none; }
+        bool start(OutputLayout, std::chrono::steady_clock::time_point, int64_t) { return !prepared.empty(); }
+        void push(size_t, const AVFrameRef&) { received++; }
+        void writeAudio(const std::vector<uint8_t>&) {}
+        void finish() {}
+        std::chrono::microseconds startLatency() const { return std::chrono::microseconds(0); }
+        double encodeLoad() { return 0; }
+        int queueDepth() { return 0; }
+        int64_t droppedFrames() const { return 0; }
+        void setQualityOffset(int) {}
+        uint64_t framesReceived() const { return received; } // Every source, since the sink was created
+    };
+}
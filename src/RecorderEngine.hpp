@@ -3,273 +3,872 @@
 // ==========================================
 #pragma once
 
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-
-#include <windows.h>
-#include <d3d11.h>
-#include <dxgi1_2.h>
-#include <wrl/client.h>
-#include <mmdeviceapi.h>
-#include <audioclient.h>
 #include <string>
 #include <vector>
 #include <deque>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <memory>
 #include <algorithm>
+#include <map>
+#include <iostream>
 
 extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-#include <libavutil/opt.h>
-#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
 }
 
-using Microsoft::WRL::ComPtr;
+#include "EncoderSink.hpp"
+#include "RetroPatcher.hpp"
+#include "core/PixelFormat.hpp"
+#include "core/MaskKernel.hpp"
+#include "core/FrameSource.hpp"
+#include "core/RingBuffer.hpp"
+#include "core/FramePool.hpp"
+#include "core/MotionTracker.hpp"
+#include "core/SensitiveDetector.hpp"
+#include "core/TileMap.hpp"
+#include "core/IncrementalConverter.hpp"
+#include "core/LoadGovernor.hpp"
 
 namespace retrorec {
 
     struct Point { int x, y; };
     struct RectArea { int x, y, w, h; };
 
-    struct RawFrame {
-        std::vector<uint8_t> data;
-        int64_t capture_time_ms;
+    inline bool rectsTouch(const RectArea& a, const RectArea& b, int slack = 0) {
+        return a.x <= b.x + b.w + slack && b.x <= a.x + a.w + slack && a.y <= b.y + b.h + slack && b.y <= a.y + a.h + slack;
+    }
+    inline RectArea rectUnion(const RectArea& a, const RectArea& b) {
+        int x0 = (std::min)(a.x, b.x), y0 = (std::min)(a.y, b.y);
+        return { x0, y0, (std::max)(a.x + a.w, b.x + b.w) - x0, (std::max)(a.y + a.h, b.y + b.h) - y0 };
+    }
+
+    using RetroRec::Core::Frame;
+    using RetroRec::Core::FrameRegion;
+    using RetroRec::Core::FrameSource;
+    using RetroRec::Core::RingBuffer;
+    using RetroRec::Core::FramePool;
+    using RetroRec::Core::MotionTracker;
+    using RetroRec::Core::SensitiveDetector;
+    using RetroRec::Core::SensitiveCandidate;
+    using RetroRec::Core::TileMap;
+    using RetroRec::Core::IncrementalConverter;
+    using RetroRec::Core::CursorShape;
+    using RetroRec::Core::CursorState;
+    using RetroRec::Core::LoadGovernor;
+    using RetroRec::Core::LoadSample;
+    using RetroRec::Core::LoadChange;
+    using RetroRec::Core::CursorStyle;
+    using RetroRec::Core::Thumbnail;
+    using RetroRec::Core::ThumbnailChain;
+    using RetroRec::Core::Bgra;
+    using RetroRec::Core::Rgba;
+    using RetroRec::Core::MosaicMask;
+
+    // Source policy without a capture backend (Linux, CI, benchmarks): no monitors, no global cursor, no audio.
+    // Sources are added with addSource() (e.g. SyntheticSource) before initialize().
+    // No memory signal either: hosts report pressure with notifyMemoryPressure().
+    struct HeadlessPlatform {
+        bool openSources(std::vector<std::unique_ptr<FrameSource>>&) { return true; }
+        bool cursorPosition(int&, int&) { return false; }
+        bool openAudio() { return false; }
+        void readAudio(std::vector<uint8_t>&) {}
+        bool memoryLow() { return false; }
     };
 
-    class AudioCapture {
-    public:
-        ComPtr<IAudioClient> audioClient;
-        ComPtr<IAudioCaptureClient> captureClient;
-        WAVEFORMATEX* pwfx = nullptr;
-        bool initialized = false;
-
-        bool init() {
-            CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-            ComPtr<IMMDeviceEnumerator> enumerator;
-            if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator)))) return false;
-            ComPtr<IMMDevice> device;
-            if (FAILED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device))) return false;
-            if (FAILED(device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, &audioClient))) return false;
-            audioClient->GetMixFormat(&pwfx);
-            if (FAILED(audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, 10000000, 0, pwfx, nullptr))) return false;
-            if (FAILED(audioClient->GetService(IID_PPV_ARGS(&captureClient)))) return false;
-            audioClient->Start();
-            initialized = true;
-            return true;
-        }
-        void read(std::vector<uint8_t>& buffer) {
-            if (!initialized) return;
-            UINT32 pktLen = 0; captureClient->GetNextPacketSize(&pktLen);
-            while (pktLen != 0) {
-                BYTE* pData; UINT32 nFrames; DWORD flags;
-                captureClient->GetBuffer(&pData, &nFrames, &flags, nullptr, nullptr);
-                if (nFrames > 0) buffer.insert(buffer.end(), pData, pData + (nFrames * pwfx->nBlockAlign));
-                captureClient->ReleaseBuffer(nFrames);
-                captureClient->GetNextPacketSize(&pktLen);
-            }
-        }
-        ~AudioCapture() { if (audioClient) audioClient->Stop(); if (pwfx) CoTaskMemFree(pwfx); }
+    // A detector hit waiting for the presenter (desktop coordinates, where the text was last seen).
+    struct Suggestion {
+        RectArea rect;
+        SensitiveCandidate::Kind kind;
+    };
+
+    // One scrubbing preview: a ring frame at 1/4 or 1/16 size, as it will be written (masks included, cursor not).
+    struct TimelineThumb {
+        int64_t timestamp; // Session clock, microseconds
+        uint64_t sequence; // Capture tick: framePreview() finds the frame by it
+        std::shared_ptr<const Thumbnail> image;
+    };
+
+    // Retro mask for one source. Zones drawn in one stroke are tracked together: one bounding box is matched,
+    // every part is masked with the displacement found for it.
+    struct RepairJob {
+        std::vector<RectArea> parts; // Source coordinates
+        RectArea bounds;
+        uint64_t anchor = 0;         // Capture tick of the first frame that got every part live (the newest part's anchor)
+        bool tracked = true;
     };
 
-    class RecorderEngine {
+    // Everything one source needs between capture and the sink. Sources never share state except inside the sink (output files).
+    template <class Pixel>
+    struct SourcePipeline {
+        size_t index = 0; // Position in the engine's source list; the sink knows the source by it
+        std::unique_ptr<FrameSource> source;
+        std::unique_ptr<RingBuffer> ring;
+        std::unique_ptr<FramePool> pool;
+        std::vector<AVFrameRef> yuv_slots;
+        std::vector<uint64_t> yuv_versions; // Per slot: converter version it holds (0 = never written)
+        size_t yuv_slot_limit = 0;          // Set when the encoders are opened: the renditions' queues plus the slot being written
+        std::unique_ptr<IncrementalConverter> converter; // Redoes only the blocks that changed since the slot was last used
+
+        std::thread worker;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::vector<RepairJob> repair_queue; // Guarded by wake_mutex
+        std::atomic<bool> repairs_queued{false}; // Frames stay in the ring while set
+        bool frames_pending = false, drain_requested = false, drained = false, shutdown = false;
+        bool dispatching = false; // Between Rec and the end of the drain; frames leaving the ring go to the sink
+
+        std::unique_ptr<SensitiveDetector<Pixel>> detector; // Own thread; scans changed tiles of the masked frames
+
+        std::shared_ptr<Frame> last_pushed; // Capture thread: newest ring frame, repeated when only the cursor moves
+        std::mutex pixel_mutex;             // Retro repairs write ring pixels while the capture thread reads last_pushed's (copy, diff)
+        uint64_t detector_seq = 0;          // Capture thread: Sequence of the frame the detector last saw (0 = none)
+        uint64_t last_draw_version = 0;
+
+        // Cursor layer (worker thread only)
+        RectArea cursor_rect{ 0, 0, 0, 0 }; // Where the previous converted frame got its cursor (w = 0: nowhere)
+        std::vector<uint8_t> cursor_scratch;
+
+        // Change tracking (worker thread only); feeds the converter and the encoder hints
+        std::shared_ptr<Frame> last_converted; // Its Sequence and masks tell whether the next frame's capture diff applies
+        TileMap dirty;                         // Converter block size
+        std::vector<AVRegionOfInterest> rois;
+        bool roi_hints = false; // The sink wants them
+    };
+
+    /**
+     * The engine, specialized at compile time for one configuration. Every policy is a type, so the per-frame loops
+     * (live masks, conversion, cursor) are instantiated and inlined for exactly that combination.
+     * - Platform: default sources, global cursor position, audio and memory pressure (HeadlessPlatform; Win32Platform in platform/Win32Platform.hpp).
+     * - Pixel:    byte layout of the ring frames (Core::Bgra, Core::Rgba). Sources must deliver it.
+     * - Mask:     kernel for live masks, retro masks and retro patches of written files (Core::MosaicMask<>), see core/MaskKernel.hpp.
+     * - Sink:     where the masked YUV frames go (FFmpegSink, NullSink), see EncoderSink.hpp.
+     * Nothing in here touches an OS API, so every configuration builds wherever FFmpeg does.
+     */
+    template <class Platform = HeadlessPlatform, class Pixel = Bgra, class Mask = MosaicMask<>, class Sink = FFmpegSink>
+    class BasicRecorderEngine {
     private:
-        ComPtr<ID3D11Device> d3d_device;
-        ComPtr<ID3D11DeviceContext> d3d_context;
-        ComPtr<IDXGIOutputDuplication> dxgi_duplication;
-        ComPtr<ID3D11Texture2D> staging_texture;
-        DXGI_OUTPUT_DESC output_desc;
-
-        AVFormatContext* fmt_ctx = nullptr;
-        AVCodecContext* video_ctx = nullptr;
-        AVStream* video_stream = nullptr;
-        AVCodecContext* audio_ctx = nullptr;
-        AVStream* audio_stream = nullptr;
-        AVFrame* raw_frame = nullptr;
-        AVFrame* audio_frame = nullptr;
-        SwsContext* sws_ctx = nullptr;
-
-        AudioCapture audio_cap;
+        using SourcePipeline = retrorec::SourcePipeline<Pixel>;
+
+        static constexpr int RECORD_FPS = 30;
+        static constexpr int MIN_HISTORY_SECONDS = 3;  // Default retro window guarantee
+        static constexpr int MAX_HISTORY_SECONDS = 30; // Every retro repair walks the whole ring
+        static constexpr int CONVERT_BLOCK = 16; // Change tracking granularity (conversion + encoder hints); must be even
+        static constexpr std::chrono::microseconds MIN_CAPTURE_GAP{ 900000 / RECORD_FPS }; // Calls sooner than this are ignored (10% timer slack)
+        // Memory caps for a consumer that falls behind: past them frames are dropped (and counted) instead of allocated
+        static constexpr size_t POOL_BACKLOG_FRAMES = RECORD_FPS / 2; // Ring frames past the window the worker may lag behind
+        static constexpr size_t ENCODER_QUEUE_FRAMES = 8;             // Converted frames each rendition may lag behind
+
+        Platform platform; // Outlives the pipelines: platform sources may depend on it
+        std::vector<std::unique_ptr<SourcePipeline>> pipelines;
+        Sink sink;
+        OutputLayout output_layout = OutputLayout::FilePerSource;
+
         bool audio_enabled = false;
+        std::vector<uint8_t> audio_buffer; // Capture thread: the platform appends the PCM of one tick
         bool is_initialized = false;
-        bool is_recording = false;
-        bool is_paused = false;
-        
+        std::atomic<bool> is_recording{false};
+        std::atomic<bool> is_paused{false};
+
         bool paint_mode = false;
         bool mosaic_mode = false;
         std::vector<Point> strokes;
         std::vector<RectArea> mosaic_zones;
+        std::vector<uint64_t> mosaic_anchors; // Per zone: first capture tick that masks it live
+        size_t retro_applied = 0;             // Zones before this index were already sent to the repair queues
+        bool retro_tracking = true;
+        std::atomic<uint64_t> capture_tick{0};
+        MotionTracker tracker;
         std::mutex draw_mutex;
 
-        std::deque<RawFrame> video_buffer;
-        const int BUFFER_FRAMES = 90; 
-        std::mutex buffer_mutex;
-
-        int screen_width = 0;
-        int screen_height = 0;
-        
-        int64_t video_pts = 0; 
-        int64_t audio_samples_written = 0;
-        
-        std::chrono::steady_clock::time_point start_time;
+        uint64_t draw_version = 0;             // Bumped on every change of the live strokes / zones
+        CursorStyle cursor_style;              // Applied at encode time, so it also changes the frames still in the ring
+
+        std::atomic<bool> detection_enabled{true};
+        bool auto_mask = false;                // Detector hits become retro masks without asking
+        std::vector<Suggestion> suggestions;   // Guarded by draw_mutex
+        std::vector<RectArea> dismissed;       // Hits inside these are not suggested again (until clearEffects)
+
+        std::chrono::steady_clock::time_point clock_origin = std::chrono::steady_clock::now();
         std::chrono::steady_clock::time_point pause_start_time;
-        std::chrono::duration<double> total_pause_duration;
+        std::chrono::duration<double> total_pause_duration; // Never reset: ring frames from before a recording share the clock
+
+        bool armed = false, stay_armed = false;
+        int64_t preroll_us = MIN_HISTORY_SECONDS * 1000000LL;
+
+        // History sizing (guarded by draw_mutex). The ring holds as many frames as the budget pays for, in the actual frame size.
+        size_t history_budget = size_t(1) << 30;  // Bytes, all sources together
+        double history_min_seconds = MIN_HISTORY_SECONDS;
+        size_t history_frames = RECORD_FPS * MIN_HISTORY_SECONDS; // Per source
+        bool memory_low = false, host_memory_low = false;
+        std::chrono::steady_clock::time_point last_memory_low, last_memory_poll;
+        std::chrono::steady_clock::time_point last_capture;                 // Capture thread
+        std::atomic<int64_t> capture_interval_us{ 1000000 / RECORD_FPS }; // Measured between captures (moving average)
+        std::atomic<bool> pool_trim_pending{false}; // Capture thread trims the frame pools to the new history
+        std::atomic<int64_t> record_origin_us{0}; // Session clock value at t=0 of the file (click minus pre-roll)
+
+        struct PendingPatch { int64_t from_us, to_us; RectArea rect; int crf_offset; };
+        std::vector<PendingPatch> pending_patches; // Guarded by draw_mutex; applied once the files are finished
+
+        // Retro patches rewrite whole files: they run on a thread of their own, so Stop (and the re-arm after it) never waits for them
+        struct PatchJob { std::string path; int64_t from_us, to_us; std::vector<PatchRegion> regions; };
+        std::thread patch_worker; // Started with the first job
+        std::mutex patch_mutex;
+        std::condition_variable patch_wake;
+        std::deque<PatchJob> patch_queue;                                       // Guarded by patch_mutex
+        bool patch_busy = false, patch_failed = false, patch_shutdown = false; // Guarded by patch_mutex
+
+        // Load governor ladder, cheapest loss first; level N applies rungs 1..N. x264 cannot change preset or size mid-track,
+        // so the last rung applies whenever encoders are opened next (the re-arm after Stop, an idle re-arm, or a cold Rec).
+        static constexpr int LIVE_LOAD_LEVELS = 5;
+        static constexpr const char* LOAD_LEVEL_NAMES[] = { "full", "detection budget / 4", "CRF +6", "capture 1/2 fps", "capture 1/3 fps", "detection off", "half size, ultrafast preset (next arm)" };
+        LoadGovernor governor{ LIVE_LOAD_LEVELS + 1 }; // Guarded by draw_mutex
+        bool governor_enabled = true;
+        std::chrono::steady_clock::time_point last_load_sample;
+        std::atomic<int64_t> dropped_frames{0}; // Capture ticks without a pool frame, converted frames without an encoder slot
+        std::atomic<int> capture_divisor{1};    // Capture every Nth tick
+        std::atomic<bool> detection_shed{false}; // Governor: no frames go to the detectors
+        uint64_t divisor_tick = 0;              // Capture thread only
+        int detection_budget_us = 2000;
+        std::vector<Rendition> requested_renditions; // As asked for; the sink got them with the governor's next-arm rungs applied
+        int armed_load_level = 0;                // Governor level (past the live rungs) the encoders were opened with
 
     public:
-        RecorderEngine() : total_pause_duration(0) {}
-        ~RecorderEngine() { stopRecording(); }
+        BasicRecorderEngine() : total_pause_duration(0) {}
+        ~BasicRecorderEngine() {
+            stopRecording();
+            { std::lock_guard<std::mutex> l(patch_mutex); patch_shutdown = true; } // Queued patches are still applied
+            patch_wake.notify_all();
+            if (patch_worker.joinable()) patch_worker.join();
+            for (auto& sp : pipelines) sp->detector.reset(); // Its callback touches engine state that dies before the pipelines
+            for (auto& sp : pipelines) { { std::lock_guard<std::mutex> l(sp->wake_mutex); sp->shutdown = true; } sp->wake.notify_one(); if (sp->worker.joinable()) sp->worker.join(); }
+            releaseEncoders();
+        }
 
+        // Adds the platform's sources (on Windows: every monitor attached to the default adapter). Extra sources (cameras,
+        // synthetic) go through addSource(); a headless engine needs at least one of those.
         bool initialize() {
             if (is_initialized) return true;
-            if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, &d3d_device, nullptr, &d3d_context))) return false;
-            ComPtr<IDXGIDevice> dxgi_dev; d3d_device.As(&dxgi_dev);
-            ComPtr<IDXGIAdapter> dxgi_adp; dxgi_dev->GetAdapter(&dxgi_adp);
-            ComPtr<IDXGIOutput> dxgi_out; dxgi_adp->EnumOutputs(0, &dxgi_out);
-            ComPtr<IDXGIOutput1> dxgi_out1; dxgi_out.As(&dxgi_out1);
-            if (FAILED(dxgi_out1->DuplicateOutput(d3d_device.Get(), &dxgi_duplication))) return false;
-            dxgi_out->GetDesc(&output_desc);
-            screen_width = output_desc.DesktopCoordinates.right - output_desc.DesktopCoordinates.left;
-            screen_height = output_desc.DesktopCoordinates.bottom - output_desc.DesktopCoordinates.top;
-            if (screen_width % 2 != 0) screen_width--;
-            if (screen_height % 2 != 0) screen_height--;
-            audio_enabled = audio_cap.init();
+            std::vector<std::unique_ptr<FrameSource>> found;
+            if (!platform.openSources(found)) return false;
+            for (auto& src : found) addSource(std::move(src));
+            if (pipelines.empty()) return false;
+            audio_enabled = platform.openAudio();
             is_initialized = true;
             return true;
         }
 
+        // Sources can only be added while not recording. Each one starts its own worker thread immediately,
+        // so the ring fills (and history exists) before the first Rec click.
+        bool addSource(std::unique_ptr<FrameSource> src) {
+            if (is_recording || !src || src->Width() <= 0 || src->Height() <= 0) return false;
+            auto sp = std::make_unique<SourcePipeline>();
+            sp->index = pipelines.size();
+            sp->source = std::move(src);
+            sp->ring = std::make_unique<RingBuffer>(history_frames);
+            sp->pool = std::make_unique<FramePool>(sp->source->Width(), sp->source->Height());
+            sp->converter = std::make_unique<IncrementalConverter>(sp->source->Width(), sp->source->Height(), CONVERT_BLOCK);
+            sp->dirty.Resize(sp->source->Width(), sp->source->Height(), sp->converter->BlockSize());
+            { std::lock_guard<std::mutex> l(draw_mutex); sp->pool->SetLimit(history_frames + 2 + POOL_BACKLOG_FRAMES); }
+            SourcePipeline* raw = sp.get();
+            sp->detector = std::make_unique<SensitiveDetector<Pixel>>(sp->source->Width(), sp->source->Height(), [this, raw](const std::vector<SensitiveCandidate>& found) { onSensitiveFound(*raw, found); });
+            { std::lock_guard<std::mutex> l(draw_mutex); sp->detector->SetBudgetMicros(governor.Level() >= 1 ? detection_budget_us / 4 : detection_budget_us); }
+            sp->worker = std::thread([this, raw] { runPipeline(*raw); });
+            pipelines.push_back(std::move(sp));
+            resizeHistory(); // Same window for every source: a new source takes its share of the budget
+            return true;
+        }
+        size_t sourceCount() const { return pipelines.size(); }
+        // The sink policy instance, for sinks that report something of their own (NullSink's frame count, test sinks)
+        Sink& getSink() { return sink; }
+        void setOutputLayout(OutputLayout layout) { if (!is_recording) output_layout = layout; }
+
         void togglePaintMode() { std::lock_guard<std::mutex> l(draw_mutex); paint_mode = !paint_mode; mosaic_mode = false; }
         void toggleMosaicMode() { std::lock_guard<std::mutex> l(draw_mutex); mosaic_mode = !mosaic_mode; paint_mode = false; }
         bool isPaintMode() { return paint_mode; }
         bool isMosaicMode() { return mosaic_mode; }
-        void addStroke(int x, int y) { std::lock_guard<std::mutex> l(draw_mutex); strokes.push_back({x,y}); }
-        void addMosaic(int x, int y, int w, int h) { std::lock_guard<std::mutex> l(draw_mutex); mosaic_zones.push_back({x,y,w,h}); }
-        void clearEffects() { std::lock_guard<std::mutex> l(draw_mutex); strokes.clear(); mosaic_zones.clear(); }
+        void addStroke(int x, int y) { std::lock_guard<std::mutex> l(draw_mutex); strokes.push_back({x,y}); draw_version++; }
+        void addMosaic(int x, int y, int w, int h) { std::lock_guard<std::mutex> l(draw_mutex); mosaic_zones.push_back({x,y,w,h}); mosaic_anchors.push_back(capture_tick + 1); draw_version++; }
+        void clearEffects() { std::lock_guard<std::mutex> l(draw_mutex); draw_version++; strokes.clear(); mosaic_zones.clear(); mosaic_anchors.clear(); retro_applied = 0; suggestions.clear(); dismissed.clear(); }
+        // Tracking on: retro masks follow scrolled / moved content. Off: the same rectangle in every past frame.
+        void setRetroTracking(bool on) { std::lock_guard<std::mutex> l(draw_mutex); retro_tracking = on; }
         std::vector<Point> getStrokes() { std::lock_guard<std::mutex> l(draw_mutex); return strokes; }
         std::vector<RectArea> getMosaicZones() { std::lock_guard<std::mutex> l(draw_mutex); return mosaic_zones; }
+        // Hide the cursor or give it a highlight halo. Takes effect for everything not yet encoded (the ring included).
+        void setCursorStyle(const CursorStyle& style) { std::lock_guard<std::mutex> l(draw_mutex); cursor_style = style; }
+        CursorStyle getCursorStyle() { std::lock_guard<std::mutex> l(draw_mutex); return cursor_style; }
+
+        // Sensitive text detection: tokens and password fields show up as suggestions (or get masked right away with auto-mask).
+        void setSensitiveDetection(bool on) { detection_enabled = on; if (!on) { std::lock_guard<std::mutex> l(draw_mutex); suggestions.clear(); } }
+        void setAutoMask(bool on) { std::lock_guard<std::mutex> l(draw_mutex); auto_mask = on; }
+        void setDetectionBudget(int micros) { std::lock_guard<std::mutex> l(draw_mutex); detection_budget_us = micros; applyLoadLevel(); }
+        std::vector<Suggestion> getSuggestions() { std::lock_guard<std::mutex> l(draw_mutex); return suggestions; }
+        // Turns every open suggestion into a mosaic zone and repairs the history. Like a hand-drawn zone, the mask is tracked
+        // back from the current frame: a region the detector has not re-reported has not changed since it was last seen.
+        void acceptSuggestions() {
+            {
+                std::lock_guard<std::mutex> l(draw_mutex);
+                for (const auto& s : suggestions) { mosaic_zones.push_back(s.rect); mosaic_anchors.push_back(capture_tick + 1); draw_version++; }
+                suggestions.clear();
+            }
+            applyRetroactiveMosaic();
+        }
+        void dismissSuggestions() { std::lock_guard<std::mutex> l(draw_mutex); for (const auto& s : suggestions) dismissed.push_back(s.rect); suggestions.clear(); }
 
+        // Queues the mosaic zones drawn since the last call on every source they overlap. Each source's worker applies them
+        // to its ring before letting another frame out, so nothing slips past and the UI thread never waits.
         void applyRetroactiveMosaic() {
-            std::lock_guard<std::mutex> l(buffer_mutex);
             std::lock_guard<std::mutex> dl(draw_mutex);
-            for (auto& f : video_buffer) {
-                uint8_t* d = f.data.data(); int ls = screen_width * 4;
-                for (const auto& r : mosaic_zones) {
-                    for (int y=r.y; y<r.y+r.h; y+=15) {
-                        for (int x=r.x; x<r.x+r.w; x+=15) {
-                            if (y>=screen_height || x>=screen_width) continue;
-                            uint8_t b=d[y*ls+x*4], g=d[y*ls+x*4+1], rv=d[y*ls+x*4+2];
-                            for (int by=y; by<(std::min)(y+15, r.y+r.h); by++)
-                                for (int bx=x; bx<(std::min)(x+15, r.x+r.w); bx++)
-                                    if (by<screen_height && bx<screen_width) { d[by*ls+bx*4]=b; d[by*ls+bx*4+1]=g; d[by*ls+bx*4+2]=rv; }
-                        }
-                    }
+            for (auto& sp : pipelines) {
+                int ox = sp->source->OriginX(), oy = sp->source->OriginY(), sw = sp->source->Width(), sh = sp->source->Height();
+                std::vector<RepairJob> jobs;
+                for (size_t i = retro_applied; i < mosaic_zones.size(); i++) {
+                    const auto& r = mosaic_zones[i];
+                    RectArea lr{ r.x - ox, r.y - oy, r.w, r.h };
+                    if (lr.x >= sw || lr.y >= sh || lr.x + lr.w <= 0 || lr.y + lr.h <= 0) continue;
+                    // Join the first job this zone touches (8px slack: a drag leaves small gaps between its squares). The job
+                    // starts from its newest anchor: frames between two anchors lack the later squares.
+                    auto it = std::find_if(jobs.begin(), jobs.end(), [&](const RepairJob& j) { return rectsTouch(lr, j.bounds, 8); });
+                    if (it == jobs.end()) { jobs.push_back({ { lr }, lr, mosaic_anchors[i], retro_tracking }); continue; }
+                    it->bounds = rectUnion(it->bounds, lr);
+                    it->parts.push_back(lr); it->anchor = (std::max)(it->anchor, mosaic_anchors[i]);
                 }
+                if (jobs.empty()) continue;
+                { std::lock_guard<std::mutex> l(sp->wake_mutex); for (auto& j : jobs) sp->repair_queue.push_back(std::move(j)); sp->repairs_queued = true; }
+                sp->wake.notify_one();
             }
+            retro_applied = mosaic_zones.size();
+        }
+
+        // Retro patch: masks `rect` (desktop coordinates) between `from` and `to` (file time) in what is already written, i.e. in
+        // history older than the ring. Only the GOPs holding those frames are re-encoded (see RetroPatcher.hpp). An MP4 can only
+        // be rewritten once its index exists, so during a recording the patch waits for stopRecording(); afterwards it goes to the
+        // files of the last recording right away. Either way the rewrite runs on the patch thread: false = nothing to patch.
+        bool retroPatch(std::chrono::microseconds from, std::chrono::microseconds to, const RectArea& rect) {
+            if (to < from || rect.w <= 0 || rect.h <= 0) return false;
+            PendingPatch p{ from.count(), to.count(), rect, crfOffsetAt(record_origin_us + from.count()) };
+            if (is_recording) { std::lock_guard<std::mutex> l(draw_mutex); pending_patches.push_back(p); return true; }
+            return queuePatches({ p });
+        }
+        // Blocks until every queued retro patch is written. False if one of them failed (file unchanged) since the last call.
+        bool waitForPatches() {
+            std::unique_lock<std::mutex> l(patch_mutex);
+            patch_wake.wait(l, [&] { return patch_queue.empty() && !patch_busy; });
+            bool ok = !patch_failed; patch_failed = false;
+            return ok;
+        }
+
+        // Always-armed mode: opens every encoder (video per source and rendition, audio), the converters and the frame pools
+        // ahead of time, so Rec only has to create the files. Stays armed across recordings until disarm().
+        bool arm(const std::vector<Rendition>& renditions = {}) {
+            if (is_recording) return false;
+            stay_armed = true;
+            return prepareEncoders(renditions);
+        }
+        void disarm() { if (is_recording) return; stay_armed = false; releaseEncoders(); }
+        bool isArmed() { return armed; }
+
+        // How much history a recording starts with. Rec includes this much of the ring, at most the retro window at that moment.
+        void setPreRoll(double seconds) { preroll_us = (int64_t)((std::max)(0.0, (std::min)(seconds, (double)MAX_HISTORY_SECONDS)) * 1000000); }
+
+        // History is sized in bytes: the ring keeps as much as `budget_bytes` pays for (all sources together, at their real frame
+        // size), but never less than `min_window_seconds` and never more than MAX_HISTORY_SECONDS. 1 GiB: ~9 s at 720p; at 4K the minimum wins.
+        void setHistoryBudget(size_t budget_bytes, double min_window_seconds = MIN_HISTORY_SECONDS) {
+            { std::lock_guard<std::mutex> l(draw_mutex); history_budget = budget_bytes; history_min_seconds = (std::max)(0.1, (std::min)(min_window_seconds, (double)MAX_HISTORY_SECONDS)); }
+            resizeHistory();
+        }
+        // Memory pressure from the host (the platform's own signal is polled as well). History shrinks to the minimum window,
+        // oldest frames first and only after pending repairs are applied, and grows back once there was no pressure for 10 s.
+        void notifyMemoryPressure(bool low) {
+            { std::lock_guard<std::mutex> l(draw_mutex); host_memory_low = low; }
+            updateMemoryPressure(std::chrono::steady_clock::now());
         }
+        // How far back a mask drawn now is guaranteed to reach: a full ring at the measured capture rate (the host decides how
+        // often captureFrame() runs, up to RECORD_FPS), or the age of the oldest frame in a ring still filling. More when the screen was static.
+        std::chrono::milliseconds retroWindow() { return std::chrono::milliseconds(retroWindowMicros(std::chrono::steady_clock::now()) / 1000); }
 
-        bool startRecording() {
-            if (!is_initialized || is_recording) return false;
-            char fn[64]; time_t t = time(0); tm l; localtime_s(&l, &t); strftime(fn, 64, "Rec_%Y%m%d_%H%M%S.mp4", &l);
-            avformat_alloc_output_context2(&fmt_ctx, nullptr, nullptr, fn);
-            const AVCodec* vc = avcodec_find_encoder(AV_CODEC_ID_H264);
-            video_stream = avformat_new_stream(fmt_ctx, vc);
-            video_ctx = avcodec_alloc_context3(vc);
-            video_ctx->width = screen_width; video_ctx->height = screen_height; video_ctx->time_base = {1, 30}; video_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
-            av_opt_set(video_ctx->priv_data, "preset", "ultrafast", 0);
-            av_opt_set(video_ctx->priv_data, "crf", "23", 0);
-            av_opt_set(video_ctx->priv_data, "tune", "zerolatency", 0);
-            avcodec_open2(video_ctx, vc, nullptr);
-            avcodec_parameters_from_context(video_stream->codecpar, video_ctx);
-            video_stream->time_base = video_ctx->time_base;
-
-            const AVCodec* ac = avcodec_find_encoder(AV_CODEC_ID_AAC);
-            audio_stream = avformat_new_stream(fmt_ctx, ac);
-            audio_ctx = avcodec_alloc_context3(ac);
-            audio_ctx->sample_fmt = AV_SAMPLE_FMT_FLTP; audio_ctx->bit_rate = 128000; audio_ctx->sample_rate = 48000;
-#if LIBAVCODEC_VERSION_MAJOR >= 60
-            AVChannelLayout cl; av_channel_layout_default(&cl, 2); audio_ctx->ch_layout = cl;
-#else
-            audio_ctx->channels = 2; audio_ctx->channel_layout = AV_CH_LAYOUT_STEREO;
-#endif
-            if (avcodec_open2(audio_ctx, ac, nullptr) >= 0) {
-                avcodec_parameters_from_context(audio_stream->codecpar, audio_ctx);
-                audio_stream->time_base = {1, 48000};
-                audio_frame = av_frame_alloc(); audio_frame->nb_samples = audio_ctx->frame_size; audio_frame->format = audio_ctx->sample_fmt;
-#if LIBAVCODEC_VERSION_MAJOR >= 60
-                av_channel_layout_copy(&audio_frame->ch_layout, &audio_ctx->ch_layout);
-#else
-                audio_frame->channels = 2; audio_frame->channel_layout = AV_CH_LAYOUT_STEREO;
-#endif
-                av_frame_get_buffer(audio_frame, 0);
+        // Scrubbing: `count` thumbnails of one source's ring, evenly spaced in time from `from_ago` to `to_ago` before now,
+        // oldest first (the frame on screen at each point; a static stretch yields one entry). Built on first use and kept
+        // until the frame changes or leaves the ring, so dragging over the same range again reads nothing at full size.
+        std::vector<TimelineThumb> timelineStrip(size_t source, int count, std::chrono::milliseconds from_ago, std::chrono::milliseconds to_ago = std::chrono::milliseconds(0), ThumbnailChain::Level level = ThumbnailChain::Sixteenth) {
+            std::vector<TimelineThumb> strip;
+            if (source >= pipelines.size() || count <= 0 || from_ago < to_ago) return strip;
+            auto frames = pipelines[source]->ring->GetSnapshot();
+            int64_t now = clockMicros(std::chrono::steady_clock::now());
+            int64_t lo = now - std::chrono::duration_cast<std::chrono::microseconds>(from_ago).count(), hi = now - std::chrono::duration_cast<std::chrono::microseconds>(to_ago).count();
+            const ThumbnailChain* last = nullptr; // Repeats share the chain: same picture
+            for (int k = 0; k < count; k++) {
+                int64_t t = count == 1 ? hi : lo + (hi - lo) * k / (count - 1);
+                auto it = std::upper_bound(frames.begin(), frames.end(), t, [](int64_t v, const std::shared_ptr<Frame>& f) { return v < f->Timestamp; });
+                if (it == frames.begin()) { if (frames.empty() || frames.front()->Timestamp > hi) continue; } else --it; // Before the ring: its oldest frame
+                Frame& f = **it;
+                if (!f.Thumbs || f.Thumbs.get() == last) continue;
+                last = f.Thumbs.get();
+                if (auto img = f.Thumbs->Get(level, f.Data(), f.Width, f.Height)) strip.push_back({ f.Timestamp, f.Sequence, std::move(img) });
             }
-            if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE)) avio_open(&fmt_ctx->pb, fn, AVIO_FLAG_WRITE);
-            avformat_write_header(fmt_ctx, nullptr);
-            sws_ctx = sws_getContext(screen_width, screen_height, AV_PIX_FMT_BGRA, screen_width, screen_height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
-            raw_frame = av_frame_alloc(); raw_frame->format = video_ctx->pix_fmt; raw_frame->width = screen_width; raw_frame->height = screen_height; av_frame_get_buffer(raw_frame, 32);
-            video_pts = 0; audio_samples_written = 0; is_recording = true; is_paused = false;
-            start_time = std::chrono::steady_clock::now() - std::chrono::seconds(3);
-            total_pause_duration = std::chrono::duration<double>(0);
+            return strip;
+        }
+        // The frame under the scrubber at 1/4 size; nullptr once it has left the ring.
+        std::shared_ptr<const Thumbnail> framePreview(size_t source, uint64_t sequence, ThumbnailChain::Level level = ThumbnailChain::Quarter) {
+            if (source >= pipelines.size()) return nullptr;
+            for (auto& f : pipelines[source]->ring->GetSnapshot()) if (f->Sequence == sequence && f->Thumbs) return f->Thumbs->Get(level, f->Data(), f->Width, f->Height);
+            return nullptr;
+        }
+
+        // Every rendition gets its own file (per source with FilePerSource) and its own encoder thread per source.
+        // Armed with the same renditions: only files and threads are created here. Otherwise encoders are opened first (cold start).
+        // No renditions = the armed ones, or one full-res rendition with the default settings.
+        bool startRecording(const std::vector<Rendition>& renditions = {}) {
+            if (!is_initialized || is_recording || pipelines.empty()) return false;
+            auto click = std::chrono::steady_clock::now();
+            if (!armed || (!renditions.empty() && renditions != requested_renditions) || armed_load_level != nextArmLoadLevel()) { if (!prepareEncoders(renditions.empty() ? requested_renditions : renditions)) return false; }
+            int64_t preroll = (std::min)(preroll_us, retroWindowMicros(click));
+            if (!sink.start(output_layout, click, preroll)) return false;
+            // One clock for every source, so tracks of a multi-track file (or files of one session) line up.
+            // The file starts pre-roll before the click.
+            is_paused = false;
+            record_origin_us = clockMicros(click) - preroll;
+            for (auto& sp : pipelines) { std::lock_guard<std::mutex> l(sp->wake_mutex); sp->dispatching = true; }
+            is_recording = true;
             return true;
         }
 
-        void pauseRecording() { if (is_recording && !is_paused) { is_paused = true; pause_start_time = std::chrono::steady_clock::now(); } }
-        void resumeRecording() { if (is_recording && is_paused) { is_paused = false; total_pause_duration += (std::chrono::steady_clock::now() - pause_start_time); } }
+        // Click-to-first-packet time of the last recording (0 until the first packet was written).
+        std::chrono::microseconds startLatency() { return sink.startLatency(); }
 
-        void encodeAndWrite(const RawFrame& rf) {
-            uint8_t* src[] = { (uint8_t*)rf.data.data() }; int strd[] = { screen_width * 4 };
-            av_frame_make_writable(raw_frame); sws_scale(sws_ctx, src, strd, 0, screen_height, raw_frame->data, raw_frame->linesize);
-            raw_frame->pts = rf.capture_time_ms * 30 / 1000; video_pts = raw_frame->pts;
-            avcodec_send_frame(video_ctx, raw_frame); AVPacket* p = av_packet_alloc();
-            while (avcodec_receive_packet(video_ctx, p) == 0) { av_packet_rescale_ts(p, video_ctx->time_base, video_stream->time_base); p->stream_index = video_stream->index; av_interleaved_write_frame(fmt_ctx, p); av_packet_unref(p); }
-            av_packet_free(&p);
+        // Load governor: watches encoder load, encoder queues, ring backlog and lost capture ticks, and walks LOAD_LEVEL_NAMES up
+        // under sustained pressure and back down once there is headroom again. It keeps sampling between recordings, where the
+        // encoders are idle, so a level reached under load decays instead of sticking to the next recording. On by default.
+        struct LoadStats {
+            int level = 0;
+            std::string level_name;
+            LoadSample last;
+            int64_t dropped_frames = 0;
+            std::vector<LoadChange> changes; // Every level change since the engine started
+        };
+        void setLoadGovernor(bool on) {
+            std::lock_guard<std::mutex> l(draw_mutex);
+            governor_enabled = on;
+            if (!on && governor.Level() != 0) { governor.Reset(clockMicros(std::chrono::steady_clock::now())); applyLoadLevel(); }
+        }
+        // Thresholds and hold times (LoadGovernor::Config); the defaults suit a desktop.
+        void setLoadGovernorConfig(const LoadGovernor::Config& config) { std::lock_guard<std::mutex> l(draw_mutex); governor.SetConfig(config); }
+        LoadStats loadStats() {
+            std::lock_guard<std::mutex> l(draw_mutex);
+            return { governor.Level(), LOAD_LEVEL_NAMES[governor.Level()], governor.LastSample(), dropped_frames + sink.droppedFrames(), governor.Changes() };
         }
 
+        void pauseRecording() { if (is_recording && !is_paused) { is_paused = true; pause_start_time = std::chrono::steady_clock::now(); } }
+        void resumeRecording() { if (is_recording && is_paused) { is_paused = false; total_pause_duration += (std::chrono::steady_clock::now() - pause_start_time); } }
+
+        // Call at least RECORD_FPS times a second; more often is fine (the prototype calls it after every window message), since
+        // calls closer than MIN_CAPTURE_GAP to the last capture return right away.
         void captureFrame() {
-            DXGI_OUTDUPL_FRAME_INFO fi; ComPtr<IDXGIResource> res;
-            if (dxgi_duplication->AcquireNextFrame(0, &fi, &res) == DXGI_ERROR_WAIT_TIMEOUT) return;
-            ComPtr<ID3D11Texture2D> tex; res.As(&tex);
-            if (!staging_texture) { D3D11_TEXTURE2D_DESC d; tex->GetDesc(&d); d.Usage = D3D11_USAGE_STAGING; d.CPUAccessFlags = D3D11_CPU_ACCESS_READ; d.BindFlags = 0; d.MiscFlags = 0; d3d_device->CreateTexture2D(&d, nullptr, &staging_texture); }
-            d3d_context->CopyResource(staging_texture.Get(), tex.Get()); dxgi_duplication->ReleaseFrame();
-            D3D11_MAPPED_SUBRESOURCE map; d3d_context->Map(staging_texture.Get(), 0, D3D11_MAP_READ, 0, &map);
-            RawFrame rf; rf.data.resize(screen_width * screen_height * 4);
-            if (map.RowPitch == screen_width * 4) memcpy(rf.data.data(), map.pData, rf.data.size());
-            else for (int y=0; y<screen_height; y++) memcpy(rf.data.data() + y*screen_width*4, (uint8_t*)map.pData + y*map.RowPitch, screen_width*4);
-            d3d_context->Unmap(staging_texture.Get(), 0);
             auto now = std::chrono::steady_clock::now();
-            if (is_recording) { if (is_paused) return; rf.capture_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time - total_pause_duration).count(); } else rf.capture_time_ms = 0;
-            std::lock_guard<std::mutex> dl(draw_mutex); int ls = screen_width * 4;
-            for (const auto& p : strokes) if (p.x>=0 && p.x<screen_width && p.y>=0 && p.y<screen_height) { rf.data[p.y*ls+p.x*4]=0; rf.data[p.y*ls+p.x*4+1]=0; rf.data[p.y*ls+p.x*4+2]=255; }
-            for (const auto& r : mosaic_zones) {
-                for (int y=r.y; y<r.y+r.h; y+=15) for (int x=r.x; x<r.x+r.w; x+=15) {
-                    if (y>=screen_height || x>=screen_width) continue;
-                    uint8_t b=rf.data[y*ls+x*4], g=rf.data[y*ls+x*4+1], rv=rf.data[y*ls+x*4+2];
-                    for (int by=y; by<(std::min)(y+15, r.y+r.h); by++) for (int bx=x; bx<(std::min)(x+15, r.x+r.w); bx++)
-                        if (by<screen_height && bx<screen_width) { rf.data[by*ls+bx*4]=b; rf.data[by*ls+bx*4+1]=g; rf.data[by*ls+bx*4+2]=rv; }
-                }
+            if (is_recording && is_paused) return;
+            if (last_capture.time_since_epoch().count() != 0) {
+                if (now - last_capture < MIN_CAPTURE_GAP) return;
+                int64_t gap = std::chrono::duration_cast<std::chrono::microseconds>(now - last_capture).count();
+                if (gap < 1000000) capture_interval_us = (capture_interval_us * 7 + gap) / 8; // A stall or a pause says nothing about the rate
             }
-            { std::lock_guard<std::mutex> lock(buffer_mutex); video_buffer.push_back(rf); if (video_buffer.size() > BUFFER_FRAMES) { if (is_recording && !is_paused) encodeAndWrite(video_buffer.front()); video_buffer.pop_front(); } }
-            if (is_recording && !is_paused && audio_enabled && audio_ctx) {
-                std::vector<uint8_t> ab; audio_cap.read(ab);
-                if (audio_frame) {
-                    av_frame_make_writable(audio_frame); audio_frame->pts = audio_samples_written; audio_samples_written += audio_frame->nb_samples;
-                    int nch = 2;
-#if LIBAVCODEC_VERSION_MAJOR >= 60
-                    nch = audio_ctx->ch_layout.nb_channels; 
-#else
-                    nch = audio_ctx->channels;
-#endif
-                    for (int i=0; i<audio_frame->nb_samples; i++) for (int c=0; c<nch; c++) ((float*)audio_frame->data[c])[i] = 0.0f;
-                    avcodec_send_frame(audio_ctx, audio_frame); AVPacket* ap = av_packet_alloc();
-                    while (avcodec_receive_packet(audio_ctx, ap) == 0) { av_packet_rescale_ts(ap, audio_ctx->time_base, audio_stream->time_base); ap->stream_index = audio_stream->index; av_interleaved_write_frame(fmt_ctx, ap); av_packet_unref(ap); }
-                    av_packet_free(&ap);
+            last_capture = now;
+            if (sampleLoad(now) && !is_recording && armed && stay_armed && armed_load_level != nextArmLoadLevel())
+                prepareEncoders(requested_renditions); // Idle, and the level crossed the next-arm rung: Rec stays instant
+            if (now - last_memory_poll >= std::chrono::seconds(1)) { last_memory_poll = now; updateMemoryPressure(now); }
+            if (pool_trim_pending && std::all_of(pipelines.begin(), pipelines.end(), [](const std::unique_ptr<SourcePipeline>& sp) { return sp->ring->Size() <= sp->ring->Capacity(); })) {
+                // The workers have let go of the surplus: now the pools can give it back
+                pool_trim_pending = false;
+                size_t keep; { std::lock_guard<std::mutex> l(draw_mutex); keep = history_frames + 2; }
+                for (auto& sp : pipelines) sp->pool->Trim(keep);
+            }
+            bool skip_video = capture_divisor > 1 && ++divisor_tick % capture_divisor != 0; // Governor: fewer frames, same timing
+            uint64_t tick = skip_video ? capture_tick.load() : ++capture_tick;
+            int gx = -100000, gy = -100000; platform.cursorPosition(gx, gy);
+            int64_t ts = clockMicros(now);
+            if (!skip_video) for (auto& sp : pipelines) {
+                FrameSource& src = *sp->source; int w = src.Width(), h = src.Height(), ls = w * 4, ox = src.OriginX(), oy = src.OriginY();
+                auto f = sp->pool->Acquire(); if (!f) { dropped_frames++; continue; }
+                bool fresh = src.Grab(f->Data());
+                CursorState cur = src.Cursor();
+                if (cur.X < 0 && !cur.Shape) { cur.X = gx - ox; cur.Y = gy - oy; } // Position only (encoder hints)
+                if (cur.X < 0 || cur.Y < 0 || cur.X >= w || cur.Y >= h) { cur.X = cur.Y = -1; cur.Visible = false; }
+
+                bool repeat = false;
+                if (!fresh) {
+                    // Nothing new on screen. If only the cursor moved, the ring still needs a frame for the new position.
+                    if (!sp->last_pushed || cur.SameAs(sp->last_pushed->Cursor) || (!cur.Visible && !sp->last_pushed->Cursor.Visible)) continue; // Frame goes straight back to the pool
+                    std::lock_guard<std::mutex> dl(draw_mutex);
+                    if (draw_version == sp->last_draw_version) { auto r = sp->pool->Repeat(*sp->last_pushed); if (r) { f = r; repeat = true; } }
+                    if (!repeat) { std::lock_guard<std::mutex> pl(sp->pixel_mutex); memcpy(f->Data(), sp->last_pushed->Data(), sp->pool->FrameBytes()); } // New live masks must go on a copy
                 }
+                f->IsKeyFrame = false; f->Timestamp = ts; f->Sequence = tick; f->Masked.clear(); f->Cursor = std::move(cur);
+                // Thumbnails follow the pixels: a repeat shares them, a reused frame drops its old ones (or a chain a shell still shares)
+                if (repeat) f->Thumbs = sp->last_pushed->Thumbs;
+                else if (!f->Thumbs || f->Thumbs.use_count() > 1) f->Thumbs = std::make_shared<ThumbnailChain>();
+                else f->Thumbs->Invalidate();
+                {
+                    // A repeat shares pixels that already carry exactly these masks: only the bookkeeping is redone
+                    std::lock_guard<std::mutex> dl(draw_mutex); uint8_t* d = f->Data();
+                    if (!repeat) for (const auto& p : strokes) { int x = p.x - ox, y = p.y - oy; if (x>=0 && x<w && y>=0 && y<h) Pixel::Store(d + y*ls + x*4, 255, 0, 0); }
+                    for (const auto& r : mosaic_zones) { if (!repeat) Mask::Apply(d, w, h, r.x - ox, r.y - oy, r.w, r.h); f->Masked.push_back({ r.x - ox, r.y - oy, r.w, r.h }); }
+                    sp->last_draw_version = draw_version;
+                }
+                // What changed since the previous ring frame, after masking: diffed once here, then shared by the detector and the converter
+                if (f->Changed.Cols() == 0) f->Changed.Resize(w, h, CONVERT_BLOCK);
+                f->Changed.Clear();
+                // A repair landing right after the diff is caught by the worker (the frames' masks differ); it just must not land during it
+                if (sp->last_pushed) { std::lock_guard<std::mutex> pl(sp->pixel_mutex); f->Changed.Diff(sp->last_pushed->Data(), f->Data()); } // A repeat shares the pixels: nothing changed
+                f->ChangedSince = sp->last_pushed ? sp->last_pushed->Sequence : 0;
+                if (detection_enabled && !detection_shed) {
+                    const bool synced = f->ChangedSince != 0 && f->ChangedSince == sp->detector_seq; // Its mirror holds the previous frame
+                    if (!repeat) sp->detector->Submit(f->Data(), synced ? &f->Changed : nullptr); // Masked content is already safe; no need to flag it again
+                    if (!repeat || synced) sp->detector_seq = f->Sequence; // Same pixels: a repeat keeps it in sync
+                }
+                sp->last_pushed = f;
+                sp->ring->Push(std::move(f));
+                { std::lock_guard<std::mutex> l(sp->wake_mutex); sp->frames_pending = true; }
+                sp->wake.notify_one();
             }
+            if (is_recording && !is_paused && audio_enabled) { audio_buffer.clear(); platform.readAudio(audio_buffer); sink.writeAudio(audio_buffer); } // Keeps its capacity
+        }
+
+        // Workers write out the frames their ring still holds, then the sink finishes its files. The ring keeps them as history.
+        void stopRecording() {
+            if (!is_recording) return;
+            for (auto& sp : pipelines) { { std::lock_guard<std::mutex> l(sp->wake_mutex); sp->drain_requested = true; sp->drained = false; } sp->wake.notify_all(); }
+            for (auto& sp : pipelines) { std::unique_lock<std::mutex> l(sp->wake_mutex); sp->wake.wait(l, [&] { return sp->drained; }); }
+            sink.finish();
+            is_recording = false;
+            std::vector<PendingPatch> patches;
+            { std::lock_guard<std::mutex> l(draw_mutex); patches.swap(pending_patches); }
+            if (!patches.empty()) queuePatches(patches); // Mapped onto the tracks just written, rewritten in the background
+            // Flushed encoders cannot take new frames: re-arm right away, so the next Rec is instant again
+            std::vector<Rendition> rends = requested_renditions;
+            releaseEncoders();
+            if (stay_armed) prepareEncoders(rends); // With whatever the governor decided about preset and size
         }
-        void stopRecording() { if (!is_recording) return; { std::lock_guard<std::mutex> l(buffer_mutex); while (!video_buffer.empty()) { encodeAndWrite(video_buffer.front()); video_buffer.pop_front(); } } av_write_trailer(fmt_ctx); if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE)) avio_closep(&fmt_ctx->pb); avcodec_free_context(&video_ctx); avcodec_free_context(&audio_ctx); avformat_free_context(fmt_ctx); sws_freeContext(sws_ctx); is_recording = false; }
         bool isRecording() { return is_recording; }
         bool isPaused() { return is_paused; }
+
+    private:
+        // Session clock: microseconds since the engine started, minus every pause. Ring frames are stamped with it
+        // whether or not a recording is running, so the pre-roll keeps its real timing.
+        int64_t clockMicros(std::chrono::steady_clock::time_point t) const {
+            return std::chrono::duration_cast<std::chrono::microseconds>(t - clock_origin - total_pause_duration).count();
+        }
+
+        int64_t retroWindowMicros(std::chrono::steady_clock::time_point at) {
+            size_t frames; int divisor;
+            { std::lock_guard<std::mutex> l(draw_mutex); frames = history_frames; divisor = capture_divisor; }
+            int64_t us = (int64_t)frames * capture_interval_us.load() * divisor;
+            for (auto& sp : pipelines) if (sp->ring->Size() < sp->ring->Capacity()) us = (std::min)(us, sp->ring->Size() ? clockMicros(at) - sp->ring->OldestTimestamp() : 0);
+            return (std::max)(us, (int64_t)0);
+        }
+
+        bool prepareEncoders(const std::vector<Rendition>& renditions) {
+            if (!is_initialized || pipelines.empty()) return false;
+            releaseEncoders();
+            std::vector<SinkSource> sources;
+            for (auto& sp : pipelines) sources.push_back({ sp->source->Name(), sp->source->Width(), sp->source->Height() });
+            requested_renditions = renditions.empty() ? std::vector<Rendition>{ Rendition{} } : renditions;
+            armed_load_level = nextArmLoadLevel();
+            std::vector<Rendition> effective = requested_renditions;
+            for (auto& r : effective) if (armed_load_level >= 1) { r.preset = "ultrafast"; r.downscale = 2; }
+            if (!sink.prepare(sources, effective, RECORD_FPS)) return false;
+            for (auto& sp : pipelines) {
+                int w = sp->source->Width(), h = sp->source->Height();
+                sp->roi_hints = sink.wantsRegionsOfInterest();
+                sp->yuv_slot_limit = 2 + sink.renditions().size() * ENCODER_QUEUE_FRAMES;
+                sp->pool->Reserve(sp->ring->Capacity() + 2); // Ring + the frame being captured + the one kept for diffing
+                for (int i = 0; i < 4; i++) acquireYuvSlot(sp->yuv_slots, w, h);
+            }
+            armed = true;
+            return true;
+        }
+
+        // Maps each patch onto every written video track whose source it overlaps (scaled to the rendition, rounded outwards)
+        // and queues one rewrite per file for the patch thread. The tracks are read here: the next recording replaces them.
+        bool queuePatches(const std::vector<PendingPatch>& patches) {
+            const std::vector<WrittenTrack>& tracks = sink.writtenTracks();
+            std::vector<PatchJob> jobs;
+            for (const auto& p : patches) {
+                std::map<std::string, std::vector<PatchRegion>> per_file;
+                for (const auto& t : tracks) {
+                    if (t.source >= pipelines.size() || t.cfg.width <= 0 || t.cfg.height <= 0) continue;
+                    const FrameSource& src = *pipelines[t.source]->source;
+                    int sw = src.Width(), sh = src.Height();
+                    int x0 = (std::max)(p.rect.x - src.OriginX(), 0), y0 = (std::max)(p.rect.y - src.OriginY(), 0);
+                    int x1 = (std::min)(p.rect.x + p.rect.w - src.OriginX(), sw), y1 = (std::min)(p.rect.y + p.rect.h - src.OriginY(), sh);
+                    if (x1 <= x0 || y1 <= y0) continue;
+                    PatchRegion r; r.stream_index = t.stream_index; r.cfg = t.cfg; r.threads = t.threads; r.crf_offset = p.crf_offset;
+                    r.x = (int)((int64_t)x0 * t.cfg.width / sw); r.y = (int)((int64_t)y0 * t.cfg.height / sh);
+                    r.w = (int)(((int64_t)x1 * t.cfg.width + sw - 1) / sw) - r.x; r.h = (int)(((int64_t)y1 * t.cfg.height + sh - 1) / sh) - r.y;
+                    per_file[t.path].push_back(r);
+                }
+                for (auto& [path, regions] : per_file) jobs.push_back({ path, p.from_us, p.to_us, std::move(regions) });
+            }
+            if (jobs.empty()) return false;
+            {
+                std::lock_guard<std::mutex> l(patch_mutex);
+                for (auto& j : jobs) patch_queue.push_back(std::move(j));
+                if (!patch_worker.joinable()) patch_worker = std::thread([this] { runPatches(); });
+            }
+            patch_wake.notify_all();
+            return true;
+        }
+
+        // Patch thread: rewrites the queued files one by one, in order. A file that fails is left as it was.
+        void runPatches() {
+            std::unique_lock<std::mutex> l(patch_mutex);
+            for (;;) {
+                patch_wake.wait(l, [&] { return !patch_queue.empty() || patch_shutdown; });
+                if (patch_queue.empty()) return; // Shutdown, and nothing left to write
+                PatchJob job = std::move(patch_queue.front()); patch_queue.pop_front();
+                patch_busy = true;
+                l.unlock();
+                RetroPatcher<Mask> patcher(job.path, job.from_us, job.to_us);
+                bool done = patcher.run(job.regions);
+                const PatchStats& st = patcher.statistics();
+                std::cout << "[RetroPatch] " << job.path << (done ? ": re-encoded " : ": FAILED (file unchanged) after ") << st.gops_patched << " of " << st.gops
+                          << " GOPs, " << st.frames_reencoded << " frames" << std::endl;
+                l.lock();
+                patch_busy = false; patch_failed = patch_failed || !done;
+                patch_wake.notify_all();
+            }
+        }
+
+        // Ring capacity from the byte budget: one window for all sources, since they share a clock. Under memory pressure: the minimum.
+        // Frames over the new capacity leave through the workers (converted if recording); the pools give back idle frames afterwards.
+        void resizeHistory() {
+            size_t tick_bytes = 0;
+            for (auto& sp : pipelines) tick_bytes += sp->pool->FrameBytes();
+            if (tick_bytes == 0) return;
+            size_t frames;
+            {
+                std::lock_guard<std::mutex> l(draw_mutex);
+                size_t min_frames = (size_t)(history_min_seconds * RECORD_FPS + 0.5), max_frames = (size_t)MAX_HISTORY_SECONDS * RECORD_FPS;
+                frames = memory_low ? min_frames : (std::max)(min_frames, (std::min)(history_budget / tick_bytes, max_frames));
+                if (frames == history_frames) return;
+                if (frames < history_frames) pool_trim_pending = true;
+                history_frames = frames;
+            }
+            std::cout << "[History] " << frames << " frames per source (" << (double)frames / RECORD_FPS << " s, " << (frames * tick_bytes >> 20) << " MB"
+                      << (memory_low ? ", memory pressure" : "") << ")" << std::endl;
+            for (auto& sp : pipelines) {
+                sp->pool->SetLimit(frames + 2 + POOL_BACKLOG_FRAMES); // Ring + the frame being captured + the one kept for diffing + backlog
+                sp->ring->SetCapacity(frames);
+                { std::lock_guard<std::mutex> l(sp->wake_mutex); sp->frames_pending = true; }
+                sp->wake.notify_one();
+            }
+        }
+
+        void updateMemoryPressure(std::chrono::steady_clock::time_point now) {
+            bool os_low = platform.memoryLow();
+            {
+                std::lock_guard<std::mutex> l(draw_mutex);
+                bool low = os_low || host_memory_low;
+                if (low) last_memory_low = now;
+                bool next = low || (memory_low && now - last_memory_low < std::chrono::seconds(10));
+                if (next == memory_low) return;
+                memory_low = next;
+            }
+            resizeHistory();
+        }
+
+        static int crfOffsetFor(int level) { return level >= 2 ? 6 : 0; }
+        // The CRF offset the governor had applied at session time `at` (a retro patch re-encodes with it)
+        int crfOffsetAt(int64_t at) {
+            std::lock_guard<std::mutex> l(draw_mutex);
+            int level = 0;
+            for (const auto& c : governor.Changes()) { if (c.TimeUs > at) break; level = c.To; }
+            return crfOffsetFor(level);
+        }
+
+        int nextArmLoadLevel() { std::lock_guard<std::mutex> l(draw_mutex); return (std::max)(0, governor.Level() - LIVE_LOAD_LEVELS); }
+
+        // Capture thread, recording or not (paused excepted): a few samples per second for the governor. True if the level changed.
+        bool sampleLoad(std::chrono::steady_clock::time_point now) {
+            if (now - last_load_sample < std::chrono::milliseconds(250)) return false;
+            last_load_sample = now;
+            LoadSample s;
+            s.EncodeLoad = sink.encodeLoad(); s.QueueDepth = sink.queueDepth(); s.DroppedFrames = dropped_frames + sink.droppedFrames();
+            const double frame_s = capture_interval_us.load() * capture_divisor / 1e6;
+            for (auto& sp : pipelines) s.RingBacklog = (std::max)(s.RingBacklog, (std::max)((int)sp->ring->Size() - (int)sp->ring->Capacity(), 0) * frame_s);
+            std::lock_guard<std::mutex> l(draw_mutex);
+            if (!governor_enabled || !governor.Update(s, clockMicros(now))) return false;
+            const LoadChange& c = governor.Changes().back();
+            std::cout << "[Governor] " << c.From << " -> " << c.To << " (" << LOAD_LEVEL_NAMES[c.To] << "): encode load " << s.EncodeLoad
+                      << ", queue " << s.QueueDepth << ", backlog " << s.RingBacklog << " s, dropped " << s.DroppedFrames << std::endl;
+            applyLoadLevel();
+            return true;
+        }
+
+        // Live rungs (caller holds draw_mutex). The next-arm rungs are read by prepareEncoders().
+        void applyLoadLevel() {
+            int level = governor.Level();
+            for (auto& sp : pipelines) sp->detector->SetBudgetMicros(level >= 1 ? detection_budget_us / 4 : detection_budget_us);
+            sink.setQualityOffset(crfOffsetFor(level));
+            capture_divisor = level >= 4 ? 3 : level >= 3 ? 2 : 1;
+            detection_shed = level >= 5; // Back on: the detector gets the next frame whole
+        }
+
+        void releaseEncoders() {
+            sink.release();
+            for (auto& sp : pipelines) {
+                sp->yuv_slots.clear(); sp->yuv_versions.clear();
+                sp->last_converted.reset(); sp->roi_hints = false; sp->cursor_rect = { 0, 0, 0, 0 };
+            }
+            armed = false;
+        }
+
+        // Detector thread. Hits grow into existing suggestions (a token being typed is found again every few frames)
+        // and skip anything already masked or dismissed.
+        void onSensitiveFound(SourcePipeline& sp, const std::vector<SensitiveCandidate>& found) {
+            if (!detection_enabled) return;
+            bool apply = false;
+            {
+                std::lock_guard<std::mutex> l(draw_mutex);
+                for (const auto& c : found) {
+                    RectArea r{ c.X + sp.source->OriginX(), c.Y + sp.source->OriginY(), c.W, c.H };
+                    auto inside = [&](const RectArea& o) { return r.x >= o.x && r.y >= o.y && r.x + r.w <= o.x + o.w && r.y + r.h <= o.y + o.h; };
+                    if (std::any_of(dismissed.begin(), dismissed.end(), inside) || std::any_of(mosaic_zones.begin(), mosaic_zones.end(), inside)) continue;
+                    if (auto_mask) { mosaic_zones.push_back(r); mosaic_anchors.push_back(capture_tick + 1); draw_version++; apply = true; continue; }
+                    auto it = std::find_if(suggestions.begin(), suggestions.end(), [&](const Suggestion& s) { return s.kind == c.Type && rectsTouch(s.rect, r); });
+                    if (it != suggestions.end()) it->rect = rectUnion(it->rect, r);
+                    else suggestions.push_back({ r, c.Type });
+                }
+            }
+            if (apply) applyRetroactiveMosaic();
+        }
+
+        // Encoder hints for one frame, in source coordinates. Earlier entries win where regions overlap (x264 applies them last to first),
+        // so masks come first: a mask over a changing area must still get no bits.
+        void buildRegionsOfInterest(SourcePipeline& sp, const Frame* f) {
+            static constexpr int CURSOR_BOX = 96;
+            static constexpr size_t MAX_DIRTY_RUNS = 128;
+            auto add = [&](int x, int y, int w, int h, AVRational q) {
+                int x0 = (std::max)(x, 0), y0 = (std::max)(y, 0), x1 = (std::min)(x + w, f->Width), y1 = (std::min)(y + h, f->Height);
+                if (x1 <= x0 || y1 <= y0) return;
+                AVRegionOfInterest r{}; r.self_size = sizeof(AVRegionOfInterest); r.left = x0; r.top = y0; r.right = x1; r.bottom = y1; r.qoffset = q;
+                sp.rois.push_back(r);
+            };
+            sp.rois.clear();
+            for (const auto& m : f->Masked) add(m.X, m.Y, m.W, m.H, { 3, 5 });
+            if (f->Cursor.X >= 0) add(f->Cursor.X - CURSOR_BOX / 2, f->Cursor.Y - CURSOR_BOX / 2, CURSOR_BOX, CURSOR_BOX, { -1, 5 });
+
+            // Changed tiles (horizontal runs per tile row). When most of the screen moved there is nothing to prefer.
+            size_t total = (size_t)sp.dirty.Cols() * sp.dirty.Rows(), runs = 0, ts = sp.dirty.TileSize();
+            if (sp.dirty.Count() == 0 || sp.dirty.Count() > total / 2) return;
+            for (int r = 0; r < sp.dirty.Rows() && runs < MAX_DIRTY_RUNS; r++) {
+                for (int c = 0; c < sp.dirty.Cols(); c++) {
+                    if (!sp.dirty.IsSet(c, r)) continue;
+                    int c1 = c; while (c1 + 1 < sp.dirty.Cols() && sp.dirty.IsSet(c1 + 1, r)) c1++;
+                    add(c * (int)ts, r * (int)ts, (c1 - c + 1) * (int)ts, (int)ts, { -1, 10 }); runs++;
+                    c = c1;
+                }
+            }
+        }
+
+        // Converts the (already masked) ring frame once and hands a reference to the sink (every rendition shares it).
+        void convertAndDispatch(SourcePipeline& sp, const std::shared_ptr<Frame>& fp) {
+            const Frame& f = *fp;
+            if (f.Timestamp < record_origin_us) return; // Older than the pre-roll
+
+            // What changed since the previously converted frame: the capture-time diff, when that frame is the one it was taken against
+            // (nothing known = everything)
+            bool known = sp.last_converted && f.ChangedSince != 0 && f.ChangedSince == sp.last_converted->Sequence;
+            sp.dirty.Clear();
+            if (known) {
+                sp.dirty.Merge(f.Changed);
+                // Masks one frame has and the other lacks count as changed whatever the diff says: a retro repair writes into
+                // ring frames after their diff was taken (and into pixels repeats share).
+                auto mark_missing = [&](const std::vector<FrameRegion>& from, const std::vector<FrameRegion>& in) {
+                    for (const auto& m : from)
+                        if (std::none_of(in.begin(), in.end(), [&](const FrameRegion& o) { return o.X == m.X && o.Y == m.Y && o.W == m.W && o.H == m.H; })) sp.dirty.MarkRect(m.X, m.Y, m.W, m.H);
+                };
+                mark_missing(f.Masked, sp.last_converted->Masked);
+                mark_missing(sp.last_converted->Masked, f.Masked);
+            } else sp.dirty.MarkAll();
+            sp.last_converted = fp;
+
+            // Cursor sprite: its blocks and the ones it left count as changed, so every slot gets it (and loses the old one) exactly once.
+            // Aligned to 2 px: it is converted on its own, over whatever the slot got from the frame.
+            CursorStyle style; { std::lock_guard<std::mutex> l(draw_mutex); style = cursor_style; }
+            RectArea cr{ 0, 0, 0, 0 };
+            if (RetroRec::Core::CursorBounds(f.Cursor, style, f.Width, f.Height, cr.x, cr.y, cr.w, cr.h)) {
+                int x1 = (std::min)((cr.x + cr.w + 1) & ~1, f.Width), y1 = (std::min)((cr.y + cr.h + 1) & ~1, f.Height);
+                cr.x &= ~1; cr.y &= ~1; cr.w = x1 - cr.x; cr.h = y1 - cr.y;
+                sp.dirty.MarkRect(cr.x, cr.y, cr.w, cr.h);
+            }
+            if (sp.cursor_rect.w > 0) sp.dirty.MarkRect(sp.cursor_rect.x, sp.cursor_rect.y, sp.cursor_rect.w, sp.cursor_rect.h);
+            sp.cursor_rect = cr;
+            sp.converter->Advance(&sp.dirty);
+
+            // Update the slot: only the blocks it is missing, all of them for a fresh slot or a frame that changed everywhere.
+            // One converter for every case, so patched blocks and whole frames come out identical (no seams).
+            size_t slot = 0;
+            AVFrameRef yuv = acquireYuvSlot(sp.yuv_slots, f.Width, f.Height, &slot, sp.yuv_slot_limit);
+            if (!yuv) { dropped_frames++; return; } // The encoders are that far behind; the converter catches the next slot up on everything skipped
+            sp.yuv_versions.resize(sp.yuv_slots.size(), 0);
+            sp.converter->template Update<Pixel>(f.Data(), yuv->data, yuv->linesize, sp.yuv_versions[slot]);
+            sp.yuv_versions[slot] = sp.converter->Version();
+            if (cr.w > 0) {
+                // Composite on a copy: the ring frame may share its pixels with newer frames, and must stay cursor-free (the next frame is diffed against it)
+                const size_t fs = (size_t)f.Width * 4, rs = (size_t)cr.w * 4;
+                sp.cursor_scratch.resize(rs * cr.h);
+                for (int y = 0; y < cr.h; y++) memcpy(sp.cursor_scratch.data() + y * rs, f.Data() + (cr.y + y) * fs + (size_t)cr.x * 4, rs);
+                CursorState local = f.Cursor; local.X -= cr.x; local.Y -= cr.y;
+                RetroRec::Core::CompositeCursor<Pixel>(sp.cursor_scratch.data(), cr.w, cr.h, local, style);
+                IncrementalConverter::ConvertRect<Pixel>(sp.cursor_scratch.data(), rs, yuv->data, yuv->linesize, cr.x, cr.y, cr.w, cr.h);
+            }
+            yuv->pts = f.Timestamp - record_origin_us; // Microseconds since the start of the file; every rendition rescales to its own fps
+            if (sp.roi_hints) { buildRegionsOfInterest(sp, &f); setRegionsOfInterest(yuv.get(), sp.rois.data(), sp.rois.size()); } // Rewrites the slot's own
+            sink.push(sp.index, yuv);
+        }
+
+        // Per-source worker: applies queued repairs, then converts whatever fell out of the retro window (on Stop: the whole ring).
+        void runPipeline(SourcePipeline& sp) {
+            // One frame at a time under pixel_mutex: the newest ring frame may be the one the capture thread is copying or diffing
+            auto mask = [&sp](uint8_t* d, int w, int h, int x, int y, int rw, int rh) { std::lock_guard<std::mutex> pl(sp.pixel_mutex); Mask::Apply(d, w, h, x, y, rw, rh); };
+            auto repair = [&](const std::vector<RepairJob>& repairs) {
+                for (const auto& job : repairs) {
+                    const int window_ms = (int)(sp.ring->SpanMicros() / 1000) + 1; // The whole ring
+                    if (!job.tracked) { for (const auto& r : job.parts) sp.ring->ApplyRetroactiveMask(window_ms, r.x, r.y, r.w, r.h, mask); continue; }
+                    const RectArea& b = job.bounds;
+                    sp.ring->ApplyTrackedRetroactiveMask(job.anchor, b.x, b.y, b.w, b.h, tracker, [&](uint8_t* d, int w, int h, int dx, int dy) {
+                        std::lock_guard<std::mutex> pl(sp.pixel_mutex);
+                        for (const auto& r : job.parts) Mask::Apply(d, w, h, r.x + dx, r.y + dy, r.w, r.h);
+                    });
+                }
+            };
+            for (;;) {
+                std::vector<RepairJob> repairs; bool drain, shutdown, dispatch;
+                {
+                    std::unique_lock<std::mutex> l(sp.wake_mutex);
+                    sp.wake.wait(l, [&] { return sp.frames_pending || sp.drain_requested || sp.shutdown || !sp.repair_queue.empty(); });
+                    repairs.swap(sp.repair_queue); sp.repairs_queued = false; drain = sp.drain_requested; shutdown = sp.shutdown; dispatch = sp.dispatching; sp.frames_pending = false;
+                }
+                repair(repairs);
+                // Not recording: history just ages out. Nothing leaves while a repair is queued; the next round applies it first.
+                while (!sp.repairs_queued) { auto f = sp.ring->PopExpired(); if (!f) break; if (dispatch) convertAndDispatch(sp, f); }
+                if (drain) {
+                    // Write out what the ring still holds, but leave it there: it is the pre-roll of a Rec pressed right after Stop.
+                    // A zone drawn meanwhile is applied before the next frame goes out, like outside a drain.
+                    for (const auto& f : sp.ring->GetSnapshot()) {
+                        if (sp.repairs_queued) {
+                            { std::lock_guard<std::mutex> l(sp.wake_mutex); repairs.clear(); repairs.swap(sp.repair_queue); sp.repairs_queued = false; }
+                            repair(repairs);
+                        }
+                        convertAndDispatch(sp, f);
+                    }
+                    { std::lock_guard<std::mutex> l(sp.wake_mutex); sp.drain_requested = false; sp.drained = true; sp.dispatching = false; }
+                    sp.wake.notify_all();
+                }
+                if (shutdown) return;
+            }
+        }
     };
 }
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+#include "EncoderSink.hpp"
+#include "core/PixelFormat.hpp"
+#include "core/IncrementalConverter.hpp"
+
+namespace retrorec {
+
+    // One rectangle to mask in one video track of a written file, in that track's pixel coordinates.
+    struct PatchRegion {
+        int stream_index = -1;
+        int x = 0, y = 0, w = 0, h = 0;
+        Rendition cfg;       // Settings the track was encoded with (resolved: preset and size as the governor left them)
+        int threads = 0;     // Encoder threads of the track (0 = all cores)
+        int crf_offset = 0;  // CRF offset the load governor had applied at the time; set on the open encoder, like the sink does
+    };
+
+    struct PatchStats {
+        int gops = 0;         // GOPs of the patched tracks
+        int gops_patched = 0; // Decoded, masked and re-encoded; the rest was copied
+        int64_t frames_reencoded = 0;
+    };
+
+    // Parameter sets (SPS, PPS) of an MP4 avcC box and the NAL length size its samples use. False if it is no avcC.
+    inline bool parseAvcC(const uint8_t* d, int n, int& length_size, std::vector<std::vector<uint8_t>>& param_sets) {
+        if (!d || n < 7 || d[0] != 1) return false;
+        length_size = (d[4] & 3) + 1;
+        int pos = 5;
+        for (int list = 0; list < 2; list++) { // SPS, then PPS
+            if (pos >= n) return false;
+            int count = list == 0 ? (d[pos] & 0x1f) : d[pos];
+            pos++;
+            for (int i = 0; i < count; i++) {
+                if (pos + 2 > n) return false;
+                int len = (d[pos] << 8) | d[pos + 1]; pos += 2;
+                if (pos + len > n) return false;
+                param_sets.emplace_back(d + pos, d + pos + len); pos += len;
+            }
+        }
+        return true;
+    }
+
+    // Annex B (start codes, what x264 emits) -> length-prefixed NALs (what MP4 samples hold). Parameter sets go to `param_sets`
+    // instead of the sample (the track's avcC has them), access unit delimiters are dropped.
+    inline void annexBToLengthPrefixed(const uint8_t* d, int n, int length_size, std::vector<uint8_t>& out, std::vector<std::vector<uint8_t>>& param_sets) {
+        out.clear();
+        auto next_start = [&](int from) { for (int i = from; i + 2 < n; i++) if (d[i] == 0 && d[i + 1] == 0 && d[i + 2] == 1) return i; return n; };
+        for (int start = next_start(0); start < n;) {
+            int nal = start + 3, end = next_start(nal), nal_end = end;
+            while (nal_end > nal && d[nal_end - 1] == 0) nal_end--; // Leading zero of the next 4-byte start code
+            if (nal_end > nal) {
+                int type = d[nal] & 0x1f;
+                if (type == 7 || type == 8) param_sets.emplace_back(d + nal, d + nal_end);
+                else if (type != 9) {
+                    uint32_t len = (uint32_t)(nal_end - nal);
+                    for (int b = length_size - 1; b >= 0; b--) out.push_back((uint8_t)(len >> (8 * b)));
+                    out.insert(out.end(), d + nal, d + nal_end);
+                }
+            }
+            start = end;
+        }
+    }
+
+    // Masks a rectangle of a decoded YUV420P frame with a mask kernel. Only the rectangle (2 px aligned) goes through BGRA and back.
+    template <class Mask>
+    void maskYuvRect(AVFrame* f, int x, int y, int w, int h, std::vector<uint8_t>& scratch, SwsContext*& sws) {
+        int x0 = (std::max)(x, 0) & ~1, y0 = (std::max)(y, 0) & ~1;
+        int x1 = (std::min)((x + w + 1) & ~1, f->width & ~1), y1 = (std::min)((y + h + 1) & ~1, f->height & ~1);
+        if (x1 <= x0 || y1 <= y0) return;
+        int rw = x1 - x0, rh = y1 - y0;
+        sws = sws_getCachedContext(sws, rw, rh, AV_PIX_FMT_YUV420P, rw, rh, AV_PIX_FMT_BGRA, SWS_POINT, nullptr, nullptr, nullptr);
+        if (!sws) return;
+        scratch.resize((size_t)rw * rh * 4);
+        const uint8_t* src[] = { f->data[0] + (size_t)y0 * f->linesize[0] + x0, f->data[1] + (size_t)(y0 / 2) * f->linesize[1] + x0 / 2, f->data[2] + (size_t)(y0 / 2) * f->linesize[2] + x0 / 2 };
+        uint8_t* dst[] = { scratch.data() }; int dst_stride[] = { rw * 4 };
+        sws_scale(sws, src, f->linesize, 0, rh, dst, dst_stride);
+        Mask::Apply(scratch.data(), rw, rh, x - x0, y - y0, w, h);
+        RetroRec::Core::IncrementalConverter::ConvertRect<RetroRec::Core::Bgra>(scratch.data(), (size_t)rw * 4, f->data, f->linesize, x0, y0, rw, rh);
+    }
+
+    /**
+     * Retro patch of a finished MP4: masks regions in the frames between from_us and to_us (file time) without re-rendering the file.
+     * One remux pass. Per patched track the packets of the current GOP are held back until the next keyframe, then:
+     * - no frame of the GOP in range: stream copy, bit-exact;
+     * - otherwise: decode the GOP, mask the frames in range, re-encode it with the track's settings (a fresh encoder starts with
+     *   an IDR, so the GOP stays self-contained) and write it back with the original timestamps.
+     * Decode / encode cost follows the GOPs touched, not the length of the recording; the rest is a copy.
+     * Relies on what FFmpegSink writes: H.264 in YUV420P without B-frames (zerolatency), closed GOPs. Anything else, or a re-encode
+     * whose parameter sets differ from the track's avcC, aborts the patch. The file is only replaced once the new one is complete.
+     */
+    template <class Mask>
+    class RetroPatcher {
+        struct Track {
+            std::vector<PatchRegion> regions;
+            std::vector<SwsContext*> sws; // Per region (sizes differ)
+            AVCodecContext* dec = nullptr;
+            std::vector<AVPacket*> gop;   // Held back until the next keyframe, decode order
+            int length_size = 4;
+            std::vector<std::vector<uint8_t>> param_sets; // From the track's avcC
+        };
+
+        std::string path;
+        int64_t from_us, to_us;
+        AVFormatContext* in = nullptr;
+        AVFormatContext* out = nullptr;
+        std::vector<std::unique_ptr<Track>> tracks; // Per input stream; null = copied as is
+        std::vector<uint8_t> scratch, nal_buffer;
+        PatchStats stats;
+
+    public:
+        RetroPatcher(std::string file, int64_t from, int64_t to) : path(std::move(file)), from_us(from), to_us(to) {}
+        ~RetroPatcher() {
+            for (auto& t : tracks) {
+                if (!t) continue;
+                for (AVPacket* p : t->gop) av_packet_free(&p);
+                for (SwsContext* s : t->sws) sws_freeContext(s);
+                avcodec_free_context(&t->dec);
+            }
+            avformat_close_input(&in);
+            if (out) { if (out->pb) avio_closep(&out->pb); avformat_free_context(out); }
+        }
+
+        const PatchStats& statistics() const { return stats; }
+
+        bool run(const std::vector<PatchRegion>& regions) {
+            if (avformat_open_input(&in, path.c_str(), nullptr, nullptr) < 0 || avformat_find_stream_info(in, nullptr) < 0) return false;
+            if (avformat_alloc_output_context2(&out, nullptr, nullptr, path.c_str()) < 0) return false;
+            tracks.resize(in->nb_streams);
+            for (unsigned i = 0; i < in->nb_streams; i++) {
+                AVStream* is = in->streams[i];
+                AVStream* os = avformat_new_stream(out, nullptr);
+                if (!os || avcodec_parameters_copy(os->codecpar, is->codecpar) < 0) return false;
+                os->codecpar->codec_tag = 0; os->time_base = is->time_base; os->disposition = is->disposition;
+                av_dict_copy(&os->metadata, is->metadata, 0);
+            }
+            av_dict_copy(&out->metadata, in->metadata, 0);
+            for (const auto& r : regions) {
+                if (r.stream_index < 0 || r.stream_index >= (int)in->nb_streams) continue;
+                auto& t = tracks[r.stream_index];
+                if (!t) { t = std::make_unique<Track>(); if (!openTrack(*t, in->streams[r.stream_index])) return false; }
+                t->regions.push_back(r); t->sws.push_back(nullptr);
+            }
+            if (std::none_of(tracks.begin(), tracks.end(), [](const std::unique_ptr<Track>& t) { return t != nullptr; })) return true; // Nothing in this file
+
+            std::string tmp = path + ".patch";
+            if (!(out->oformat->flags & AVFMT_NOFILE) && avio_open(&out->pb, tmp.c_str(), AVIO_FLAG_WRITE) < 0) return false;
+            bool ok = avformat_write_header(out, nullptr) >= 0;
+            AVPacket* pkt = av_packet_alloc();
+            while (ok && av_read_frame(in, pkt) >= 0) {
+                int si = pkt->stream_index;
+                Track* t = tracks[si].get();
+                if (!t) { ok = write(pkt, si); av_packet_unref(pkt); continue; }
+                if ((pkt->flags & AV_PKT_FLAG_KEY) && !t->gop.empty()) ok = flushGop(*t, si);
+                t->gop.push_back(av_packet_clone(pkt)); av_packet_unref(pkt);
+            }
+            for (size_t i = 0; ok && i < tracks.size(); i++) if (tracks[i] && !tracks[i]->gop.empty()) ok = flushGop(*tracks[i], (int)i);
+            av_packet_free(&pkt);
+            if (ok) ok = av_write_trailer(out) >= 0;
+            if (out->pb) avio_closep(&out->pb);
+            std::error_code ec;
+            if (!ok) { std::filesystem::remove(tmp, ec); return false; }
+            avformat_close_input(&in); // The original must not be open while it is replaced (Windows)
+            std::filesystem::rename(tmp, path, ec);
+            if (ec) { std::filesystem::remove(tmp, ec); return false; }
+            return true;
+        }
+
+    private:
+        bool openTrack(Track& t, AVStream* is) {
+            if (is->codecpar->codec_id != AV_CODEC_ID_H264) return false;
+            if (!parseAvcC(is->codecpar->extradata, is->codecpar->extradata_size, t.length_size, t.param_sets)) return false;
+            const AVCodec* dc = avcodec_find_decoder(AV_CODEC_ID_H264);
+            t.dec = avcodec_alloc_context3(dc);
+            if (!t.dec || avcodec_parameters_to_context(t.dec, is->codecpar) < 0) return false;
+            t.dec->pkt_timebase = is->time_base;
+            return avcodec_open2(t.dec, dc, nullptr) >= 0;
+        }
+
+        bool write(AVPacket* p, int stream) {
+            av_packet_rescale_ts(p, in->streams[stream]->time_base, out->streams[stream]->time_base);
+            p->stream_index = stream; p->pos = -1;
+            return av_interleaved_write_frame(out, p) >= 0;
+        }
+
+        bool inRange(const AVPacket* p, const AVStream* s) const {
+            int64_t us = av_rescale_q(p->pts == AV_NOPTS_VALUE ? p->dts : p->pts, s->time_base, AVRational{ 1, 1000000 });
+            return us >= from_us && us <= to_us;
+        }
+
+        static bool receivePackets(AVCodecContext* enc, std::vector<AVPacket*>& out_packets) {
+            for (;;) {
+                AVPacket* p = av_packet_alloc();
+                int r = avcodec_receive_packet(enc, p);
+                if (r < 0) { av_packet_free(&p); return r == AVERROR(EAGAIN) || r == AVERROR_EOF; }
+                out_packets.push_back(p);
+            }
+        }
+
+        bool flushGop(Track& t, int stream) {
+            std::vector<AVPacket*> gop; gop.swap(t.gop);
+            stats.gops++;
+            const AVStream* is = in->streams[stream];
+            bool ok = true;
+            if (std::any_of(gop.begin(), gop.end(), [&](const AVPacket* p) { return inRange(p, is); })) ok = reencode(t, stream, gop);
+            else for (AVPacket* p : gop) if (ok) ok = write(p, stream);
+            for (AVPacket* p : gop) av_packet_free(&p);
+            return ok;
+        }
+
+        bool reencode(Track& t, int stream, const std::vector<AVPacket*>& gop) {
+            const AVStream* is = in->streams[stream];
+            // One frame per packet: no B-frames, and draining returns whatever the decoder held back
+            std::vector<AVFrame*> frames;
+            auto receive = [&] { for (;;) { AVFrame* f = av_frame_alloc(); if (avcodec_receive_frame(t.dec, f) < 0) { av_frame_free(&f); return; } frames.push_back(f); } };
+            for (AVPacket* p : gop) { if (avcodec_send_packet(t.dec, p) < 0) break; receive(); }
+            avcodec_send_packet(t.dec, nullptr); receive(); avcodec_flush_buffers(t.dec);
+            bool ok = frames.size() == gop.size() && t.dec->pix_fmt == AV_PIX_FMT_YUV420P;
+
+            AVCodecContext* enc = nullptr;
+            const int rc_fps = (std::max)(1, t.regions[0].cfg.fps);
+            if (ok) {
+                // Opened like the sink opened the track's encoder (its parameter sets must come out the same), then given the CRF
+                // the frames around this GOP were encoded with, so the patch matches its neighbours in quality and bitrate
+                const PatchRegion& orig = t.regions[0];
+                Rendition rc = orig.cfg; rc.width = is->codecpar->width; rc.height = is->codecpar->height;
+                enc = openH264Encoder(rc, orig.threads > 0 ? orig.threads : (std::max)(1, (int)std::thread::hardware_concurrency()));
+                ok = enc != nullptr;
+                if (ok && orig.crf_offset != 0) av_opt_set(enc->priv_data, "crf", std::to_string(rc.crf + orig.crf_offset).c_str(), 0);
+            }
+            std::vector<AVPacket*> encoded;
+            for (size_t i = 0; ok && i < frames.size(); i++) {
+                AVFrame* f = frames[i];
+                if (inRange(gop[i], is)) {
+                    ok = av_frame_make_writable(f) >= 0;
+                    for (size_t r = 0; ok && r < t.regions.size(); r++) maskYuvRect<Mask>(f, t.regions[r].x, t.regions[r].y, t.regions[r].w, t.regions[r].h, scratch, t.sws[r]);
+                }
+                f->pts = av_rescale_q((int64_t)i, AVRational{ 1, rc_fps }, ENCODER_TIME_BASE); f->pict_type = AV_PICTURE_TYPE_NONE;
+                ok = ok && avcodec_send_frame(enc, f) >= 0 && receivePackets(enc, encoded);
+            }
+            if (ok) ok = avcodec_send_frame(enc, nullptr) >= 0 && receivePackets(enc, encoded) && encoded.size() == gop.size() && (encoded[0]->flags & AV_PKT_FLAG_KEY);
+
+            // Back into the track: its NAL framing, its timestamps. The copied GOPs decode with the avcC parameter sets, so ours must match.
+            for (size_t i = 0; ok && i < encoded.size(); i++) {
+                std::vector<std::vector<uint8_t>> sets;
+                annexBToLengthPrefixed(encoded[i]->data, encoded[i]->size, t.length_size, nal_buffer, sets);
+                for (const auto& s : sets) if (std::find(t.param_sets.begin(), t.param_sets.end(), s) == t.param_sets.end()) ok = false;
+                if (!ok) { std::cout << "[RetroPatch] Re-encoded GOP does not match the track's SPS/PPS, giving up" << std::endl; break; }
+                AVPacket* p = av_packet_alloc();
+                ok = av_new_packet(p, (int)nal_buffer.size()) >= 0;
+                if (ok) {
+                    memcpy(p->data, nal_buffer.data(), nal_buffer.size());
+                    p->pts = gop[i]->pts; p->dts = gop[i]->dts; p->duration = gop[i]->duration; p->flags = encoded[i]->flags & AV_PKT_FLAG_KEY;
+                    ok = write(p, stream);
+                }
+                av_packet_free(&p);
+            }
+            for (AVFrame* f : frames) av_frame_free(&f);
+            for (AVPacket* p : encoded) av_packet_free(&p);
+            avcodec_free_context(&enc);
+            if (ok) { stats.gops_patched++; stats.frames_reencoded += (int64_t)gop.size(); }
+            return ok;
+        }
+    };
+}
@@ -0,0 +1,126 @@
+/**
+ * RetroRec - Cursor Layer (The "Spotlight")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * The cursor is NOT part of the captured image. Every ring frame carries a tiny sidecar
+ * (position + a shared pointer to the shape) and the cursor is alpha-composited right before
+ * encoding. Consequences:
+ * 1. A cursor moving over a static screen costs a sidecar, not a frame: the ring frame shares
+ *    the previous frame's pixels (see FramePool::Repeat).
+ * 2. Hide / highlight are decided at encode time, so they also apply to the frames still in the
+ *    Ring Buffer (same "after the fact" window as the retro masks).
+ * 3. Shapes change rarely; all frames with the same shape share one CursorShape.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PixelFormat.hpp"
+
+namespace RetroRec::Core {
+
+    struct CursorShape {
+        int Width = 0, Height = 0;
+        int HotX = 0, HotY = 0;
+        std::vector<uint8_t> Bgra;   // Straight alpha
+        std::vector<uint8_t> Invert; // 1 = invert the screen pixel (I-beam and other XOR cursors). Empty if none.
+
+        // Pointer shape types as reported by Desktop Duplication (DXGI_OUTDUPL_POINTER_SHAPE_TYPE_*)
+        static constexpr int MONOCHROME = 1, COLOR = 2, MASKED_COLOR = 4;
+
+        static std::shared_ptr<const CursorShape> FromPointerShape(int type, int width, int height, int pitch, const uint8_t* data, int hotX, int hotY) {
+            auto s = std::make_shared<CursorShape>();
+            s->HotX = hotX; s->HotY = hotY;
+            s->Width = width;
+            s->Height = type == MONOCHROME ? height / 2 : height; // AND mask on top, XOR mask below
+            s->Bgra.assign(static_cast<size_t>(s->Width) * s->Height * 4, 0);
+            bool anyInvert = false;
+            std::vector<uint8_t> invert(static_cast<size_t>(s->Width) * s->Height, 0);
+
+            for (int y = 0; y < s->Height; y++) {
+                for (int x = 0; x < s->Width; x++) {
+                    uint8_t* d = &s->Bgra[(static_cast<size_t>(y) * s->Width + x) * 4];
+                    const size_t i = static_cast<size_t>(y) * s->Width + x;
+                    if (type == MONOCHROME) {
+                        const uint8_t bit = static_cast<uint8_t>(0x80 >> (x % 8));
+                        const bool andBit = (data[y * pitch + x / 8] & bit) != 0;
+                        const bool xorBit = (data[(y + s->Height) * pitch + x / 8] & bit) != 0;
+                        if (!andBit) { d[0] = d[1] = d[2] = xorBit ? 255 : 0; d[3] = 255; }
+                        else if (xorBit) { invert[i] = 1; anyInvert = true; }
+                    } else {
+                        const uint8_t* p = data + y * pitch + x * 4;
+                        if (type == COLOR) { d[0] = p[0]; d[1] = p[1]; d[2] = p[2]; d[3] = p[3]; }
+                        else if (p[3] == 0) { d[0] = p[0]; d[1] = p[1]; d[2] = p[2]; d[3] = 255; } // Masked color: replace
+                        else if (p[0] | p[1] | p[2]) { invert[i] = 1; anyInvert = true; }        // XOR, approximated as invert
+                    }
+                }
+            }
+            if (anyInvert) s->Invert = std::move(invert);
+            return s;
+        }
+    };
+
+    // Per-frame sidecar. A few bytes; the shape is shared.
+    struct CursorState {
+        bool Visible = false;
+        int X = -1, Y = -1; // Hot spot, frame coordinates. X < 0 = not on this frame
+        std::shared_ptr<const CursorShape> Shape;
+
+        bool SameAs(const CursorState& o) const { return Visible == o.Visible && X == o.X && Y == o.Y && Shape == o.Shape; }
+    };
+
+    struct CursorStyle {
+        bool Hidden = false;
+        bool Halo = false;
+        int HaloRadius = 28;
+        uint8_t HaloB = 0, HaloG = 220, HaloR = 255, HaloAlpha = 90;
+    };
+
+    // Area a composite touches (sprite + halo), clipped to the frame. False if nothing is drawn.
+    inline bool CursorBounds(const CursorState& c, const CursorStyle& s, int frameW, int frameH, int& x, int& y, int& w, int& h) {
+        if (s.Hidden || !c.Visible || c.X < 0) return false;
+        int x0 = frameW, y0 = frameH, x1 = 0, y1 = 0;
+        if (c.Shape) { x0 = c.X - c.Shape->HotX; y0 = c.Y - c.Shape->HotY; x1 = x0 + c.Shape->Width; y1 = y0 + c.Shape->Height; }
+        if (s.Halo) { x0 = std::min(x0, c.X - s.HaloRadius); y0 = std::min(y0, c.Y - s.HaloRadius); x1 = std::max(x1, c.X + s.HaloRadius + 1); y1 = std::max(y1, c.Y + s.HaloRadius + 1); }
+        x0 = std::max(x0, 0); y0 = std::max(y0, 0); x1 = std::min(x1, frameW); y1 = std::min(y1, frameH);
+        if (x1 <= x0 || y1 <= y0) return false;
+        x = x0; y = y0; w = x1 - x0; h = y1 - y0;
+        return true;
+    }
+
+    // Draws halo (under) and cursor (over) into a tightly packed frame of the given layout.
+    template <class Pixel = Bgra>
+    void CompositeCursor(uint8_t* bgra, int frameW, int frameH, const CursorState& c, const CursorStyle& s) {
+        int bx, by, bw, bh;
+        if (!CursorBounds(c, s, frameW, frameH, bx, by, bw, bh)) return;
+        const size_t stride = static_cast<size_t>(frameW) * 4;
+        auto blend = [](uint8_t* d, int b, int g, int r, int a) {
+            d[Pixel::B] = static_cast<uint8_t>((d[Pixel::B] * (255 - a) + b * a + 127) / 255);
+            d[Pixel::G] = static_cast<uint8_t>((d[Pixel::G] * (255 - a) + g * a + 127) / 255);
+            d[Pixel::R] = static_cast<uint8_t>((d[Pixel::R] * (255 - a) + r * a + 127) / 255);
+        };
+
+        if (s.Halo) {
+            const int r2 = s.HaloRadius * s.HaloRadius;
+            for (int y = std::max(by, c.Y - s.HaloRadius); y <= std::min(by + bh - 1, c.Y + s.HaloRadius); y++)
+                for (int x = std::max(bx, c.X - s.HaloRadius); x <= std::min(bx + bw - 1, c.X + s.HaloRadius); x++)
+                    if ((x - c.X) * (x - c.X) + (y - c.Y) * (y - c.Y) <= r2) blend(bgra + y * stride + x * 4, s.HaloB, s.HaloG, s.HaloR, s.HaloAlpha);
+        }
+
+        if (!c.Shape) return;
+        const CursorShape& sh = *c.Shape;
+        const int ox = c.X - sh.HotX, oy = c.Y - sh.HotY;
+        for (int y = std::max(0, -oy); y < sh.Height && oy + y < frameH; y++) {
+            for (int x = std::max(0, -ox); x < sh.Width && ox + x < frameW; x++) {
+                uint8_t* d = bgra + (oy + y) * stride + (ox + x) * 4;
+                const size_t i = static_cast<size_t>(y) * sh.Width + x;
+                if (!sh.Invert.empty() && sh.Invert[i]) { d[Pixel::B] = 255 - d[Pixel::B]; d[Pixel::G] = 255 - d[Pixel::G]; d[Pixel::R] = 255 - d[Pixel::R]; continue; }
+                const uint8_t* p = &sh.Bgra[i * 4];
+                if (p[3]) blend(d, p[0], p[1], p[2], p[3]);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * RetroRec - Frame Pool (The "Recycling Bin")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * A 1080p BGRA frame is 8 MB. Allocating (and zero-filling) one per captured frame costs more
+ * than the capture itself, so frames are allocated once and recycled.
+ * * How recycling works:
+ * The pool keeps one reference to every frame it ever created. A frame is free again as soon as
+ * the pool holds the ONLY reference, i.e. the ring, the encoder and any repair are done with it,
+ * and no repeated frame (see Repeat) still shares its pixels.
+ * Nothing is freed or allocated in steady state; the pool only grows when every frame is in flight,
+ * and never past its limit (SetLimit): then Acquire() fails and the producer drops the tick.
+ * * * Thread Safety:
+ * Acquire() is called by the single producer (the capture thread) of the owning source.
+ * Releasing (dropping a shared_ptr) may happen on any thread.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "RingBuffer.hpp"
+
+namespace RetroRec::Core {
+
+    class FramePool {
+    private:
+        std::vector<std::shared_ptr<Frame>> m_Slots;
+        std::vector<std::shared_ptr<Frame>> m_Shells; // Frames without pixels of their own (see Repeat)
+        const int m_Width, m_Height;
+        size_t m_Next = 0; // Round-robin start, so the oldest returned frames are found first
+        size_t m_Limit = SIZE_MAX; // Frames Acquire() may allocate up to
+
+        std::shared_ptr<Frame> FindFree() {
+            for (size_t i = 0; i < m_Slots.size(); i++) {
+                size_t idx = (m_Next + i) % m_Slots.size();
+                if (m_Slots[idx].use_count() == 1 && av_buffer_is_writable(m_Slots[idx]->Buffer)) {
+                    // Pairs with the release in the last owner's shared_ptr destructor: its reads of the
+                    // pixels happen before we start overwriting them.
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    m_Next = idx + 1;
+                    return m_Slots[idx];
+                }
+            }
+            return nullptr;
+        }
+
+        void ReleaseIdleShells() {
+            for (auto& s : m_Shells) if (s.use_count() == 1) { av_buffer_unref(&s->Buffer); s->Thumbs.reset(); }
+        }
+
+    public:
+        FramePool(int width, int height) : m_Width(width), m_Height(height) {}
+
+        // Returns a frame whose pixels may be overwritten. Contents are whatever it held last time.
+        // nullptr if every frame is in use and the pool is at its limit.
+        std::shared_ptr<Frame> Acquire() {
+            if (auto frame = FindFree()) return frame;
+            // Idle shells still reference the pixels (and thumbnails) of the frame they repeated; let go and look again.
+            // Only now: a shell kept on the current picture repeats it again without taking a new reference.
+            ReleaseIdleShells();
+            if (auto frame = FindFree()) return frame;
+            if (m_Slots.size() >= m_Limit) return nullptr;
+
+            auto frame = std::make_shared<Frame>();
+            frame->Width = m_Width;
+            frame->Height = m_Height;
+            frame->Buffer = av_buffer_alloc(static_cast<size_t>(m_Width) * m_Height * 4);
+            if (!frame->Buffer) return nullptr;
+            m_Slots.push_back(frame);
+            return frame;
+        }
+
+        // A frame showing the same pixels as `prev` (nothing on screen changed, e.g. only the cursor moved).
+        // Shares prev's buffer instead of copying 8 MB; costs one small Frame object, itself recycled. An idle shell
+        // already on these pixels is preferred: moving a shell to another picture costs a buffer reference (a small
+        // allocation), so after a picture change repeats allocate until the shells leaving the ring carry the new one.
+        std::shared_ptr<Frame> Repeat(const Frame& prev) {
+            std::shared_ptr<Frame> shell;
+            for (auto& s : m_Shells) {
+                if (s.use_count() != 1) continue;
+                if (s->Buffer && s->Buffer->data == prev.Buffer->data) { shell = s; break; }
+                if (!shell) shell = s;
+            }
+            if (shell) std::atomic_thread_fence(std::memory_order_acquire);
+            else { shell = std::make_shared<Frame>(); m_Shells.push_back(shell); }
+            if (!shell->Buffer || shell->Buffer->data != prev.Buffer->data) {
+                av_buffer_unref(&shell->Buffer);
+                shell->Buffer = av_buffer_ref(prev.Buffer);
+                if (!shell->Buffer) return nullptr;
+            }
+            shell->Width = prev.Width;
+            shell->Height = prev.Height;
+            return shell;
+        }
+
+        // Allocates up front what steady state will need anyway, so the first seconds of capture don't pay for it.
+        void Reserve(size_t frames) {
+            while (m_Slots.size() < frames) {
+                auto frame = std::make_shared<Frame>();
+                frame->Width = m_Width;
+                frame->Height = m_Height;
+                frame->Buffer = av_buffer_alloc(static_cast<size_t>(m_Width) * m_Height * 4);
+                if (!frame->Buffer) return;
+                m_Slots.push_back(frame);
+            }
+        }
+
+        // Frees idle frames beyond `frames` (memory pressure, smaller history). Frames still in use stay.
+        void Trim(size_t frames) {
+            ReleaseIdleShells();
+            for (size_t i = m_Slots.size(); i-- > 0 && m_Slots.size() > frames;) {
+                if (m_Slots[i].use_count() == 1 && av_buffer_is_writable(m_Slots[i]->Buffer)) m_Slots.erase(m_Slots.begin() + i);
+            }
+            m_Next = 0;
+        }
+
+        // Caps growth (a consumer that falls behind must not grow the pool without bound). Frames already allocated stay; Trim() frees them.
+        void SetLimit(size_t frames) { m_Limit = frames; }
+
+        size_t Capacity() const { return m_Slots.size(); }
+        size_t FrameBytes() const { return static_cast<size_t>(m_Width) * m_Height * 4; }
+    };
+}
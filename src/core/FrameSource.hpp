@@ -0,0 +1,88 @@
+/**
+ * RetroRec - Frame Source Interface (The "Eyes", plural)
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * The engine records N independent sources (several monitors, a camera next to the screen...).
+ * Every source gets its own Ring Buffer, Repair Queue and Encoder Thread, so a slow or
+ * busy source never stalls the others.
+ * * Implementations:
+ * - DXGIOutputSource (platform/Win32Platform.hpp): one per monitor, Windows only.
+ * - SyntheticSource (below): generated test pattern, runs anywhere. Used to load the
+ *   pipeline with several sources at once without needing real monitors.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "CursorLayer.hpp"
+
+namespace RetroRec::Core {
+
+    class FrameSource {
+    public:
+        virtual ~FrameSource() = default;
+
+        virtual std::string Name() const = 0;
+        virtual int Width() const = 0;   // Always even (YUV420 requirement)
+        virtual int Height() const = 0;
+
+        // Position on the virtual desktop. Overlay coordinates are desktop coordinates,
+        // so masks are translated by this before they touch the source's frames.
+        virtual int OriginX() const { return 0; }
+        virtual int OriginY() const { return 0; }
+
+        // Copies the latest image as tightly packed 4-byte pixels (Width() * 4 bytes per row) into dst, WITHOUT the cursor.
+        // Channel order is the engine's Pixel policy (PixelFormat.hpp); every built-in source delivers BGRA.
+        // Returns false if no new image arrived since the last call (the cursor may still have moved).
+        virtual bool Grab(uint8_t* dst) = 0;
+
+        // Cursor as of the last Grab() call. Default: the source knows nothing about the cursor.
+        virtual CursorState Cursor() const { return {}; }
+    };
+
+    // Moving test pattern: a scrolling gradient plus a bouncing block.
+    // Every call produces a new frame, so it behaves like a very busy screen.
+    class SyntheticSource : public FrameSource {
+    private:
+        std::string m_Name;
+        int m_Width, m_Height;
+        int64_t m_FrameIndex = 0;
+
+    public:
+        SyntheticSource(std::string name, int width, int height)
+            : m_Name(std::move(name)), m_Width(width & ~1), m_Height(height & ~1) {}
+
+        std::string Name() const override { return m_Name; }
+        int Width() const override { return m_Width; }
+        int Height() const override { return m_Height; }
+
+        bool Grab(uint8_t* dst) override {
+            const int shift = static_cast<int>(m_FrameIndex * 4);
+            for (int y = 0; y < m_Height; y++) {
+                uint8_t* row = dst + static_cast<size_t>(y) * m_Width * 4;
+                const uint8_t g = static_cast<uint8_t>((y + shift) & 0xFF);
+                for (int x = 0; x < m_Width; x++) {
+                    row[x * 4 + 0] = static_cast<uint8_t>((x + shift) & 0xFF);
+                    row[x * 4 + 1] = g;
+                    row[x * 4 + 2] = static_cast<uint8_t>((x ^ y) & 0xFF);
+                    row[x * 4 + 3] = 0xFF;
+                }
+            }
+
+            // Bouncing white block so motion is not a pure scroll
+            const int bw = m_Width / 8, bh = m_Height / 8;
+            if (bw > 0 && bh > 0) {
+                const int bx = static_cast<int>(m_FrameIndex * 7 % (m_Width - bw + 1));
+                const int by = static_cast<int>(m_FrameIndex * 5 % (m_Height - bh + 1));
+                for (int y = by; y < by + bh; y++)
+                    memset(dst + (static_cast<size_t>(y) * m_Width + bx) * 4, 0xFF, static_cast<size_t>(bw) * 4);
+            }
+
+            m_FrameIndex++;
+            return true;
+        }
+    };
+}
@@ -0,0 +1,95 @@
+/**
+ * RetroRec - Load Governor (The "Thermostat")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * Encoder settings are chosen for an idle machine. When something else saturates the CPU (a build
+ * during a demo), the pipeline falls behind: encoder queues grow, the ring holds more than its window,
+ * and finally the frame pool runs dry and capture ticks are lost. The governor watches those symptoms
+ * and moves along a ladder of cheaper settings one level at a time, so quality drops smoothly instead
+ * of frames disappearing.
+ * * Hysteresis: going up needs sustained pressure, going down needs a longer stretch of clear headroom
+ * (with thresholds far below the "up" ones), and every change is followed by a cooldown while its
+ * effect shows. A lost frame skips the hold time, not the cooldown.
+ * * The governor only decides and keeps the record. What a level means is up to the engine.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace RetroRec::Core {
+
+    // One observation of the pipeline: worst value over all sources and renditions.
+    struct LoadSample {
+        double EncodeLoad = 0;     // Share of wall time the busiest encoder spent encoding (1.0 = it just keeps up)
+        int QueueDepth = 0;        // Frames waiting for the busiest encoder
+        double RingBacklog = 0;    // Seconds of frames past the retro window the worker has not taken yet
+        int64_t DroppedFrames = 0; // Capture ticks lost so far (cumulative)
+    };
+
+    struct LoadChange {
+        int64_t TimeUs; // Session clock
+        int From, To;
+        LoadSample Sample; // What it was based on
+    };
+
+    class LoadGovernor {
+    public:
+        struct Config {
+            double HighLoad = 0.9, LowLoad = 0.5;
+            int HighQueue = 8, LowQueue = 1;
+            double HighBacklog = 0.25, LowBacklog = 0.05;
+            int64_t UpHoldUs = 1000000, DownHoldUs = 5000000, CooldownUs = 2000000;
+        };
+
+    private:
+        Config m_Config;
+        int m_MaxLevel;
+        int m_Level = 0;
+        int64_t m_LastSample = -1, m_LastChange = -1;
+        int64_t m_PressureSince = -1, m_ClearSince = -1;
+        int64_t m_LastDropped = 0;
+        LoadSample m_Last;
+        std::vector<LoadChange> m_Changes;
+
+    public:
+        explicit LoadGovernor(int maxLevel) : m_MaxLevel(maxLevel) {}
+        LoadGovernor(int maxLevel, const Config& config) : m_Config(config), m_MaxLevel(maxLevel) {}
+
+        // Feeds one sample; returns true if the level changed. Samples should come a few times per second.
+        bool Update(const LoadSample& s, int64_t nowUs) {
+            // A gap (paused) says nothing about load: start the hold times over
+            if (m_LastSample >= 0 && nowUs - m_LastSample > m_Config.UpHoldUs) m_PressureSince = m_ClearSince = -1;
+            m_LastSample = nowUs; m_Last = s;
+            const bool dropped = s.DroppedFrames > m_LastDropped;
+            m_LastDropped = s.DroppedFrames;
+            const bool pressure = dropped || s.EncodeLoad > m_Config.HighLoad || s.QueueDepth > m_Config.HighQueue || s.RingBacklog > m_Config.HighBacklog;
+            const bool clear = !pressure && s.EncodeLoad < m_Config.LowLoad && s.QueueDepth <= m_Config.LowQueue && s.RingBacklog < m_Config.LowBacklog;
+            m_PressureSince = pressure ? (m_PressureSince < 0 ? nowUs : m_PressureSince) : -1;
+            m_ClearSince = clear ? (m_ClearSince < 0 ? nowUs : m_ClearSince) : -1;
+            if (m_LastChange >= 0 && nowUs - m_LastChange < m_Config.CooldownUs) return false;
+
+            int to = m_Level;
+            if (pressure && m_Level < m_MaxLevel && (dropped || nowUs - m_PressureSince >= m_Config.UpHoldUs)) to++;
+            else if (clear && m_Level > 0 && nowUs - m_ClearSince >= m_Config.DownHoldUs) to--;
+            if (to == m_Level) return false;
+            m_Changes.push_back({ nowUs, m_Level, to, s });
+            m_Level = to; m_LastChange = nowUs;
+            m_PressureSince = m_ClearSince = -1;
+            return true;
+        }
+
+        // Back to level 0 (governor switched off); recorded like any other change.
+        void Reset(int64_t nowUs) {
+            if (m_Level != 0) m_Changes.push_back({ nowUs, m_Level, 0, m_Last });
+            m_Level = 0; m_LastChange = m_LastSample = m_PressureSince = m_ClearSince = -1;
+        }
+
+        void SetConfig(const Config& config) { m_Config = config; }
+
+        int Level() const { return m_Level; }
+        int MaxLevel() const { return m_MaxLevel; }
+        const LoadSample& LastSample() const { return m_Last; }
+        const std::vector<LoadChange>& Changes() const { return m_Changes; }
+    };
+}
@@ -0,0 +1,41 @@
+/**
+ * RetroRec - Mask Kernels (The "Frosted Glass")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * A mask kernel destroys the content of a rectangle, in place. The engine runs it on every live
+ * frame for every zone, and again on up to 3 s of history for every retro repair, so it is a
+ * compile-time policy: the call is inlined into the capture and repair loops.
+ * * Kernel contract:
+ *   static void Apply(uint8_t* data, int width, int height, int x, int y, int w, int h);
+ * data is a tightly packed 4-byte-per-pixel frame; the rectangle may reach outside it (clip).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace RetroRec::Core {
+
+    // Pixelates by repeating the top-left pixel of each Block x Block cell. Whole pixels are copied,
+    // so it works for any 4-byte layout.
+    template <int Block = 15>
+    struct MosaicMask {
+        static_assert(Block > 0, "Block must be positive");
+
+        static void Apply(uint8_t* d, int width, int height, int x, int y, int w, int h) {
+            const int x0 = std::max(x, 0), y0 = std::max(y, 0), x1 = std::min(x + w, width), y1 = std::min(y + h, height);
+            const size_t stride = static_cast<size_t>(width) * 4;
+            for (int cy = y0; cy < y1; cy += Block) {
+                for (int cx = x0; cx < x1; cx += Block) {
+                    uint32_t px; memcpy(&px, d + cy * stride + static_cast<size_t>(cx) * 4, 4);
+                    const int ex = std::min(cx + Block, x1), ey = std::min(cy + Block, y1);
+                    for (int py = cy; py < ey; py++) {
+                        uint8_t* row = d + py * stride;
+                        for (int xx = cx; xx < ex; xx++) memcpy(row + static_cast<size_t>(xx) * 4, &px, 4);
+                    }
+                }
+            }
+        }
+    };
+}
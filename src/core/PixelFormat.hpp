@@ -0,0 +1,27 @@
+/**
+ * RetroRec - Pixel Formats (The "Rosetta Stone")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * Ring frames are tightly packed 4-byte pixels. Which byte is which channel depends on the capture
+ * backend (Desktop Duplication delivers BGRA, most cameras and Linux grabbers RGBA), so every piece of
+ * code that looks at colors (live masks, cursor, conversion, detection) takes the layout as a
+ * compile-time policy. The channel offsets are constants, so the per-pixel loops compile to the same
+ * code as hand-written BGRA loops.
+ * * Layout-agnostic code (tile diffing, motion SAD, mosaic, copies) never needs to know.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace RetroRec::Core {
+
+    struct Bgra {
+        static constexpr int B = 0, G = 1, R = 2, A = 3;
+        static void Store(uint8_t* p, uint8_t r, uint8_t g, uint8_t b) { p[R] = r; p[G] = g; p[B] = b; }
+    };
+
+    struct Rgba {
+        static constexpr int R = 0, G = 1, B = 2, A = 3;
+        static void Store(uint8_t* p, uint8_t r, uint8_t g, uint8_t b) { p[R] = r; p[G] = g; p[B] = b; }
+    };
+}
@@ -10,44 +10,129 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <mutex>
 #include <memory>
-#include <deque>
 #include <algorithm>
 #include <iostream>
 
+extern "C" {
+#include <libavutil/buffer.h>
+}
+
+#include "MotionTracker.hpp"
+#include "CursorLayer.hpp"
+#include "Thumbnail.hpp"
+#include "TileMap.hpp"
+
 namespace RetroRec::Core {
 
+    struct FrameRegion { int X, Y, W, H; };
+
     // A single video frame with metadata
     struct Frame {
-        int64_t Timestamp;      // Microseconds (for Audio Sync)
-        int Width, Height;
-        std::vector<uint8_t> Data; // Raw Pixel Data (BGRA)
-        bool IsKeyFrame;        // For video encoding optimization
+        int64_t Timestamp = 0;  // Microseconds (for Audio Sync)
+        int Width = 0, Height = 0;
+        uint64_t Sequence = 0;  // Capture tick; lets a mask find the last frame captured before it was drawn
+        AVBufferRef* Buffer = nullptr; // Raw Pixel Data (4 bytes per pixel in the engine's Pixel layout, tightly packed). Refcounted: FFmpeg and repeated frames share it without a copy
+        bool IsKeyFrame = false; // For video encoding optimization
+        std::vector<FrameRegion> Masked; // Everything masked in this frame (live or retro); the encoder spends no bits there
+        CursorState Cursor;              // Not in the pixels: composited right before encoding
+        std::shared_ptr<ThumbnailChain> Thumbs; // Scrubbing previews, built on demand; shared with repeats of these pixels
+        TileMap Changed;                 // Blocks that differ from the frame captured before it (diffed once, at capture)
+        uint64_t ChangedSince = 0;       // Sequence of that frame (0 = none: everything changed)
+
+        Frame() = default;
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+        ~Frame() { av_buffer_unref(&Buffer); }
+
+        uint8_t* Data() { return Buffer->data; }
+        const uint8_t* Data() const { return Buffer->data; }
     };
 
     class RingBuffer {
     private:
-        std::deque<std::shared_ptr<Frame>> m_Buffer; // using shared_ptr to avoid heavy copying
-        const size_t m_MaxFrames;                    // Capacity (e.g., 30fps * 3s = 90 frames)
-        mutable std::mutex m_Mutex;                  // Guards the buffer
+        std::vector<std::shared_ptr<Frame>> m_Buffer; // Circular storage (using shared_ptr to avoid heavy copying). Grows to the
+                                                      // steady-state backlog once, then never allocates: a deque allocates a node every few pushes
+        size_t m_Head = 0, m_Count = 0;               // Oldest frame, frames held
+        size_t m_MaxFrames;                           // Capacity (e.g., 30fps * 3s = 90 frames); guarded by m_Mutex
+        mutable std::mutex m_Mutex;                   // Guards the buffer
+
+        // i-th oldest frame (caller holds m_Mutex)
+        std::shared_ptr<Frame>& At(size_t i) { return m_Buffer[(m_Head + i) % m_Buffer.size()]; }
+        const std::shared_ptr<Frame>& At(size_t i) const { return m_Buffer[(m_Head + i) % m_Buffer.size()]; }
+
+        std::shared_ptr<Frame> TakeOldest() {
+            auto frame = std::move(At(0));
+            m_Head = (m_Head + 1) % m_Buffer.size();
+            m_Count--;
+            return frame;
+        }
 
     public:
         // Constructor: Define how many seconds of history we keep
         RingBuffer(int fps, int secondsToKeep) 
             : m_MaxFrames(fps * secondsToKeep) {}
+        explicit RingBuffer(size_t maxFrames) : m_MaxFrames(maxFrames) {}
+
+        // Resizes the history (memory budget, memory pressure). Shrinking drops nothing here: the surplus
+        // leaves through PopExpired(), oldest first, so the consumer gets to apply pending repairs first.
+        void SetCapacity(size_t maxFrames) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_MaxFrames = maxFrames;
+        }
+        size_t Capacity() const {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_MaxFrames;
+        }
 
         // Producer calls this: Push a new frame
         void Push(std::shared_ptr<Frame> frame) {
             std::lock_guard<std::mutex> lock(m_Mutex);
-            
-            m_Buffer.push_back(frame);
-            
-            // If full, drop the oldest frame (The "Ring" behavior)
-            if (m_Buffer.size() > m_MaxFrames) {
-                m_Buffer.pop_front();
+            if (m_Count == m_Buffer.size()) {
+                // Full: unroll into a larger buffer (only while the backlog still grows)
+                std::vector<std::shared_ptr<Frame>> grown(std::max<size_t>(m_Buffer.size() * 2, m_MaxFrames + 4));
+                for (size_t i = 0; i < m_Count; i++) grown[i] = std::move(At(i));
+                m_Buffer.swap(grown);
+                m_Head = 0;
             }
+            m_Buffer[(m_Head + m_Count) % m_Buffer.size()] = std::move(frame);
+            m_Count++;
+        }
+
+        // Consumer calls this: Take the oldest frame once it has fallen out of the retro window.
+        // Eviction is driven by the consumer (not by Push) so that pending repairs can be applied
+        // before a frame leaves the ring. Returns nullptr if the buffer is not over capacity.
+        std::shared_ptr<Frame> PopExpired() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Count <= m_MaxFrames) return nullptr;
+            return TakeOldest();
+        }
+
+        // Consumer calls this on shutdown: Take the oldest frame regardless of capacity.
+        std::shared_ptr<Frame> PopOldest() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Count == 0) return nullptr;
+            return TakeOldest();
+        }
+
+        size_t Size() const {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Count;
+        }
+
+        // Time between the oldest and the newest frame held
+        int64_t SpanMicros() const {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Count == 0 ? 0 : At(m_Count - 1)->Timestamp - At(0)->Timestamp;
+        }
+
+        // Capture time of the oldest frame held (0 when empty)
+        int64_t OldestTimestamp() const {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Count == 0 ? 0 : At(0)->Timestamp;
         }
 
         // Consumer calls this: Get a snapshot of current buffer to write to disk
@@ -55,7 +140,10 @@ namespace RetroRec::Core {
         std::vector<std::shared_ptr<Frame>> GetSnapshot() {
             std::lock_guard<std::mutex> lock(m_Mutex);
             // Return a copy of the list (pointers are cheap to copy)
-            return std::vector<std::shared_ptr<Frame>>(m_Buffer.begin(), m_Buffer.end());
+            std::vector<std::shared_ptr<Frame>> frames;
+            frames.reserve(m_Count);
+            for (size_t i = 0; i < m_Count; i++) frames.push_back(At(i));
+            return frames;
         }
 
         /**
@@ -68,17 +156,18 @@ namespace RetroRec::Core {
         void ApplyRetroactiveMask(int durationMs, int x, int y, int w, int h, Func pixelProcessor) {
             std::lock_guard<std::mutex> lock(m_Mutex);
 
-            if (m_Buffer.empty()) return;
+            if (m_Count == 0) return;
 
             // 1. Calculate the time threshold
-            int64_t currentTime = m_Buffer.back()->Timestamp;
+            int64_t currentTime = At(m_Count - 1)->Timestamp;
             int64_t targetTime = currentTime - (durationMs * 1000); // Convert to microseconds
 
             std::cout << "[RingBuffer] Rewinding time... Processing frames since timestamp " << targetTime << std::endl;
 
             // 2. Iterate BACKWARDS from the newest frame
-            for (auto it = m_Buffer.rbegin(); it != m_Buffer.rend(); ++it) {
-                auto& frame = *it;
+            const uint8_t* lastMasked = nullptr;
+            for (size_t i = m_Count; i-- > 0;) {
+                auto& frame = At(i);
 
                 if (frame->Timestamp < targetTime) {
                     break; // We have gone back far enough
@@ -87,7 +176,52 @@ namespace RetroRec::Core {
                 // 3. Apply the processing (Blurring) directly to memory
                 // The 'pixelProcessor' is a dependency-injected function (e.g., OpenCV logic)
                 // This keeps RingBuffer clean of OpenCV headers.
-                pixelProcessor(frame->Data, frame->Width, frame->Height, x, y, w, h);
+                // Repeats share their pixels with the frame before them: one picture, masked once.
+                if (frame->Data() != lastMasked) pixelProcessor(frame->Data(), frame->Width, frame->Height, x, y, w, h);
+                lastMasked = frame->Data();
+                frame->Masked.push_back({ x, y, w, h });
+                if (frame->Thumbs) frame->Thumbs->Invalidate();
+            }
+        }
+
+        /**
+         * The "Retroactive" Magic Function, motion-tracked
+         * The mask follows the content backwards (scrolls, moved windows) instead of staying put.
+         * @param anchorSequence: first frame that already had the mask applied live; tracking starts one frame older
+         * @param x, y, w, h: the region as drawn (in the anchor frame)
+         * @param maskAt: callback (data, width, height, dx, dy) masking the region displaced by (dx, dy)
+         * Runs on a snapshot without holding the lock, so the producer keeps pushing meanwhile.
+         * Call it from the consumer thread only: the consumer is the one evicting, so no frame leaves mid-pass.
+         * Repeats (frames sharing the previous frame's pixels) are one picture: it is tracked against the
+         * frame before the whole run and masked once, so masking never destroys a template still to be matched.
+         */
+        template <typename Func>
+        void ApplyTrackedRetroactiveMask(uint64_t anchorSequence, int x, int y, int w, int h, const MotionTracker& tracker, Func maskAt) {
+            auto frames = GetSnapshot();
+            int i = static_cast<int>(frames.size()) - 1;
+            while (i >= 0 && frames[i]->Sequence >= anchorSequence) i--;
+
+            std::cout << "[RingBuffer] Tracking mask back through " << (i + 1) << " frames" << std::endl;
+
+            MotionVector pos, velocity;
+            while (i >= 0) {
+                Frame& cur = *frames[i];
+                int first = i; // Oldest frame of the run sharing these pixels
+                while (first > 0 && frames[first - 1]->Data() == cur.Data()) first--;
+                MotionVector step;
+                bool tracked = false;
+                if (first > 0 && frames[first - 1]->Width == cur.Width && frames[first - 1]->Height == cur.Height) {
+                    // Track BEFORE masking: the match needs the unmasked content of this frame
+                    step = tracker.Track(cur.Data(), frames[first - 1]->Data(), cur.Width, cur.Height, x + pos.dx, y + pos.dy, w, h, velocity);
+                    tracked = true;
+                }
+                maskAt(cur.Data(), cur.Width, cur.Height, pos.dx, pos.dy);
+                for (int k = first; k <= i; k++) {
+                    frames[k]->Masked.push_back({ x + pos.dx, y + pos.dy, w, h });
+                    if (frames[k]->Thumbs) frames[k]->Thumbs->Invalidate();
+                }
+                if (tracked) { pos.dx += step.dx; pos.dy += step.dy; velocity = step; }
+                i = first - 1;
             }
         }
     };
@@ -0,0 +1,258 @@
+/**
+ * RetroRec - Sensitive Content Detector (The "Sixth Sense")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * Flags likely secrets BEFORE they leave the Ring Buffer, so the presenter gets a prompt while
+ * a retro mask can still catch every frame. Two shapes are recognised on screen text:
+ * 1. Token: one long unbroken run of glyphs that all look different (API keys, hashes, JWTs).
+ * 2. Password field: a run of identical, evenly spaced, dot-sized glyphs.
+ * No OCR: glyphs are split by ink columns and compared by a small shape signature.
+ * * PERFORMANCE CRITICAL:
+ * - Capture thread: Submit() copies the tiles the caller says changed into a private mirror. It
+ *   does not diff: the engine diffs each frame once at capture and shares that map with the converter.
+ * - Worker thread: scans only changed tiles, and stops for this frame once the CPU budget is
+ *   spent. Leftover tiles are scanned on the next frame. Scratch is kept between frames, so a
+ *   steady scan allocates nothing.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PixelFormat.hpp"
+#include "TileMap.hpp"
+
+namespace RetroRec::Core {
+
+    struct SensitiveCandidate {
+        enum class Kind { Token, PasswordField };
+        Kind Type;
+        int X, Y, W, H; // Frame coordinates
+    };
+
+    template <class Pixel = Bgra>
+    class SensitiveDetector {
+    public:
+        using Callback = std::function<void(const std::vector<SensitiveCandidate>&)>;
+
+    private:
+        const int m_Width, m_Height;
+        std::vector<uint8_t> m_Mirror; // Last submitted frame (4 bytes per pixel), updated tile by tile
+        TileMap m_Pending;             // Changed tiles not scanned yet
+        TileMap m_Taken;               // Worker: the pending tiles of the current round
+        bool m_First = true;
+        std::atomic<int> m_BudgetUs;
+        std::atomic<int64_t> m_LastScanUs{0};
+        Callback m_OnFound;
+
+        std::thread m_Worker;
+        std::mutex m_Mutex; // Guards mirror + pending
+        std::condition_variable m_Wake;
+        bool m_HasWork = false, m_Stop = false;
+
+        struct Glyph { int x0, x1, top, bottom, ink; };
+
+        // Worker scratch (grows to the largest band once)
+        std::vector<uint8_t> m_Luma; // One band in grayscale
+        std::vector<int> m_ColInk, m_ColTop, m_ColBottom;
+        std::vector<Glyph> m_Glyphs;
+        std::vector<uint32_t> m_Signatures;
+        std::vector<SensitiveCandidate> m_Found;
+
+    public:
+        SensitiveDetector(int width, int height, Callback onFound, int budgetUs = 2000, int tileSize = 32)
+            : m_Width(width), m_Height(height), m_Mirror(static_cast<size_t>(width) * height * 4),
+              m_Pending(width, height, tileSize), m_BudgetUs(budgetUs), m_OnFound(std::move(onFound)) {
+            m_Worker = std::thread([this] { Run(); });
+        }
+
+        ~SensitiveDetector() {
+            { std::lock_guard<std::mutex> lock(m_Mutex); m_Stop = true; }
+            m_Wake.notify_one();
+            if (m_Worker.joinable()) m_Worker.join();
+        }
+
+        void SetBudgetMicros(int us) { m_BudgetUs = us; }
+        int64_t LastScanMicros() const { return m_LastScanUs; } // Worker time spent on the last frame
+
+        // Capture thread: hand over a new frame (tightly packed, Pixel layout). `changed` marks where it differs from the
+        // previously submitted frame, in any tile size; only those tiles are copied. nullptr (or the first frame) = everything.
+        void Submit(const uint8_t* bgra, const TileMap* changed = nullptr) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (m_First || !changed) {
+                    memcpy(m_Mirror.data(), bgra, m_Mirror.size());
+                    m_Pending.MarkAll();
+                    m_First = false;
+                } else {
+                    const size_t stride = static_cast<size_t>(m_Width) * 4;
+                    for (int r = 0; r < changed->Rows(); r++) {
+                        for (int c = 0; c < changed->Cols(); c++) {
+                            if (!changed->IsSet(c, r)) continue;
+                            int c1 = c; while (c1 + 1 < changed->Cols() && changed->IsSet(c1 + 1, r)) c1++; // One copy per run
+                            int x, y, w, h, x1, y1, w1, h1; changed->TileRect(c, r, x, y, w, h); changed->TileRect(c1, r, x1, y1, w1, h1);
+                            w = x1 + w1 - x;
+                            for (int row = 0; row < h; row++) {
+                                const size_t off = (y + row) * stride + static_cast<size_t>(x) * 4;
+                                memcpy(m_Mirror.data() + off, bgra + off, static_cast<size_t>(w) * 4);
+                            }
+                            m_Pending.MarkRect(x, y, w, h);
+                            c = c1;
+                        }
+                    }
+                }
+                m_HasWork = true;
+            }
+            m_Wake.notify_one();
+        }
+
+    private:
+        void Run() {
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Wake.wait(lock, [this] { return m_HasWork || m_Stop; });
+                    if (m_Stop) return;
+                    m_HasWork = false;
+                    m_Taken = m_Pending; // Walked without the lock; tiles marked meanwhile wait for the next round
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                auto deadline = start + std::chrono::microseconds(m_BudgetUs.load());
+                m_Found.clear();
+                const int ts = m_Taken.TileSize();
+                bool spent = false;
+
+                for (int r = 0; r < m_Taken.Rows() && !spent; r++) {
+                    for (int c = 0; c < m_Taken.Cols(); c++) {
+                        if (!m_Taken.IsSet(c, r)) continue;
+                        if ((spent = std::chrono::steady_clock::now() >= deadline)) break;
+                        // Take one horizontal run of changed tiles, plus a tile of context on each side
+                        // (a token typed into one tile usually starts in the tile before)
+                        int c1 = c;
+                        while (c1 + 1 < m_Taken.Cols() && m_Taken.IsSet(c1 + 1, r)) c1++;
+                        const int bx = std::max(0, (c - 1) * ts), bw = std::min(m_Width, (c1 + 2) * ts) - bx;
+                        const int by = std::max(0, r * ts - ts / 2), bh = std::min(m_Height, r * ts + ts + ts / 2) - by;
+                        {
+                            std::lock_guard<std::mutex> lock(m_Mutex);
+                            for (int k = c; k <= c1; k++) m_Pending.Unmark(k, r);
+                            CopyLuma(bx, by, bw, bh);
+                        }
+                        c = c1;
+                        ScanBand(m_Luma.data(), bw, bh, bx, by, m_Found);
+                    }
+                }
+
+                m_LastScanUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                if (!m_Found.empty() && m_OnFound) m_OnFound(m_Found);
+            }
+        }
+
+        // Mirror region -> 8-bit luma (BT.601 integer weights)
+        void CopyLuma(int x, int y, int w, int h) {
+            m_Luma.resize(static_cast<size_t>(w) * h);
+            const size_t stride = static_cast<size_t>(m_Width) * 4;
+            for (int row = 0; row < h; row++) {
+                const uint8_t* s = m_Mirror.data() + (y + row) * stride + static_cast<size_t>(x) * 4;
+                uint8_t* d = m_Luma.data() + static_cast<size_t>(row) * w;
+                for (int i = 0; i < w; i++) d[i] = static_cast<uint8_t>((s[i * 4 + Pixel::B] * 29 + s[i * 4 + Pixel::G] * 150 + s[i * 4 + Pixel::R] * 77) >> 8);
+            }
+        }
+
+        void ScanBand(const uint8_t* luma, int w, int h, int ox, int oy, std::vector<SensitiveCandidate>& out) {
+            // Background = most common shade; ink = anything clearly different from it
+            int hist[256] = {};
+            for (int i = 0; i < w * h; i++) hist[luma[i]]++;
+            const int bg = static_cast<int>(std::max_element(hist, hist + 256) - hist);
+            auto ink = [&](int x, int y) { return std::abs(luma[y * w + x] - bg) > 64; };
+
+            if (m_ColInk.size() < static_cast<size_t>(w)) { m_ColInk.resize(w); m_ColTop.resize(w); m_ColBottom.resize(w); }
+            int* colInk = m_ColInk.data(); int* colTop = m_ColTop.data(); int* colBottom = m_ColBottom.data();
+            int y = 0;
+            while (y < h) {
+                // Next text line = run of rows containing ink
+                auto rowHasInk = [&](int yy) { for (int x = 0; x < w; x++) if (ink(x, yy)) return true; return false; };
+                while (y < h && !rowHasInk(y)) y++;
+                int y0 = y;
+                while (y < h && rowHasInk(y)) y++;
+                int lineH = y - y0;
+                if (lineH < 6 || lineH > 48) continue;
+
+                for (int x = 0; x < w; x++) {
+                    colInk[x] = 0; colTop[x] = lineH; colBottom[x] = -1;
+                    for (int yy = y0; yy < y; yy++) if (ink(x, yy)) { colInk[x]++; colTop[x] = std::min(colTop[x], yy - y0); colBottom[x] = yy - y0; }
+                }
+
+                // Glyphs = runs of inked columns; words = glyphs without a space-sized gap between them
+                std::vector<Glyph>& glyphs = m_Glyphs;
+                glyphs.clear();
+                for (int x = 0; x < w;) {
+                    if (!colInk[x]) { x++; continue; }
+                    Glyph g{ x, x, lineH, -1, 0 };
+                    for (; x < w && colInk[x]; x++) { g.x1 = x; g.top = std::min(g.top, colTop[x]); g.bottom = std::max(g.bottom, colBottom[x]); g.ink += colInk[x]; }
+                    glyphs.push_back(g);
+                }
+                FindDotRuns(glyphs, lineH, ox, oy + y0, out);
+                const int spaceGap = std::max(3, lineH * 2 / 5);
+                size_t start = 0;
+                for (size_t i = 1; i <= glyphs.size(); i++) {
+                    if (i < glyphs.size() && glyphs[i].x0 - glyphs[i - 1].x1 - 1 < spaceGap) continue;
+                    ClassifyWord(glyphs, start, i, lineH, ox, oy + y0, out);
+                    start = i;
+                }
+            }
+        }
+
+        static bool IsDot(const Glyph& g) {
+            int gw = g.x1 - g.x0 + 1, gh = g.bottom - g.top + 1;
+            return gw >= 3 && gw <= 16 && std::abs(gw - gh) <= 2;
+        }
+
+        // Password field: 4+ identical dot-sized glyphs at a constant pitch (bullets are spaced wider than letters)
+        static void FindDotRuns(const std::vector<Glyph>& g, int lineH, int ox, int oy, std::vector<SensitiveCandidate>& out) {
+            size_t i = 0;
+            while (i < g.size()) {
+                if (!IsDot(g[i])) { i++; continue; }
+                const int w0 = g[i].x1 - g[i].x0, h0 = g[i].bottom - g[i].top;
+                size_t j = i + 1;
+                int pitch = -1;
+                while (j < g.size() && IsDot(g[j]) && std::abs((g[j].x1 - g[j].x0) - w0) <= 1 && std::abs((g[j].bottom - g[j].top) - h0) <= 1) {
+                    int p = g[j].x0 - g[j - 1].x0;
+                    if (p > (w0 + 1) * 3 || (pitch >= 0 && std::abs(p - pitch) > 1)) break;
+                    pitch = p; j++;
+                }
+                if (j - i >= 4) out.push_back({ SensitiveCandidate::Kind::PasswordField, ox + g[i].x0 - 4, oy - 4, g[j - 1].x1 - g[i].x0 + 9, lineH + 8 });
+                i = j;
+            }
+        }
+
+        // Token: one long, unbroken, high-entropy word (glyph shapes rarely repeat)
+        void ClassifyWord(const std::vector<Glyph>& g, size_t begin, size_t end, int lineH, int ox, int oy, std::vector<SensitiveCandidate>& out) {
+            const int n = static_cast<int>(end - begin);
+            if (n < 16) return;
+            m_Signatures.clear();
+            for (size_t i = begin; i < end; i++)
+                m_Signatures.push_back(static_cast<uint32_t>(g[i].x1 - g[i].x0) | (static_cast<uint32_t>(g[i].top) << 6) |
+                                       (static_cast<uint32_t>(g[i].bottom) << 12) | (static_cast<uint32_t>(g[i].ink / 4) << 18));
+            // Counts per signature = runs of equal values once sorted
+            std::sort(m_Signatures.begin(), m_Signatures.end());
+            double entropy = 0;
+            for (size_t i = 0; i < m_Signatures.size();) {
+                size_t j = i; while (j < m_Signatures.size() && m_Signatures[j] == m_Signatures[i]) j++;
+                double p = static_cast<double>(j - i) / n; entropy -= p * std::log2(p);
+                i = j;
+            }
+            if (entropy >= 3.2) out.push_back({ SensitiveCandidate::Kind::Token, ox + g[begin].x0 - 4, oy - 4, g[end - 1].x1 - g[begin].x0 + 9, lineH + 8 });
+        }
+    };
+}
@@ -0,0 +1,83 @@
+/**
+ * RetroRec - Tile Map (The "Change Radar")
+ * * ARCHITECTURE NOTE (v1.1 Intent):
+ * Screen recordings are mostly static. Everything that only cares about what CHANGED
+ * (detection, encoder hints, incremental conversion) works on a grid of tiles instead of pixels.
+ * * PERFORMANCE:
+ * Diff() compares tile rows with memcmp (vectorized by the C runtime) and stops at the
+ * first differing row, so a changed tile usually costs a single row compare.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace RetroRec::Core {
+
+    class TileMap {
+    private:
+        int m_Width = 0, m_Height = 0, m_TileSize = 32;
+        int m_Cols = 0, m_Rows = 0;
+        std::vector<uint8_t> m_Bits; // One byte per tile: cheaper to test than a bitset
+
+    public:
+        TileMap() = default;
+        TileMap(int width, int height, int tileSize = 32) { Resize(width, height, tileSize); }
+
+        void Resize(int width, int height, int tileSize) {
+            m_Width = width; m_Height = height; m_TileSize = tileSize;
+            m_Cols = (width + tileSize - 1) / tileSize;
+            m_Rows = (height + tileSize - 1) / tileSize;
+            m_Bits.assign(static_cast<size_t>(m_Cols) * m_Rows, 0);
+        }
+
+        int Cols() const { return m_Cols; }
+        int Rows() const { return m_Rows; }
+        int TileSize() const { return m_TileSize; }
+
+        void Clear() { std::fill(m_Bits.begin(), m_Bits.end(), 0); }
+        void MarkAll() { std::fill(m_Bits.begin(), m_Bits.end(), 1); }
+        void Mark(int col, int row) { m_Bits[static_cast<size_t>(row) * m_Cols + col] = 1; }
+        void Unmark(int col, int row) { m_Bits[static_cast<size_t>(row) * m_Cols + col] = 0; }
+        bool IsSet(int col, int row) const { return m_Bits[static_cast<size_t>(row) * m_Cols + col] != 0; }
+
+        // Marks every tile touched by the rectangle (clipped to the frame)
+        void MarkRect(int x, int y, int w, int h) {
+            int c0 = std::max(x, 0) / m_TileSize, r0 = std::max(y, 0) / m_TileSize;
+            int c1 = (std::min(x + w, m_Width) - 1) / m_TileSize, r1 = (std::min(y + h, m_Height) - 1) / m_TileSize;
+            for (int r = r0; r <= r1; r++)
+                for (int c = c0; c <= c1; c++) Mark(c, r);
+        }
+
+        void Merge(const TileMap& other) {
+            for (size_t i = 0; i < m_Bits.size() && i < other.m_Bits.size(); i++) m_Bits[i] |= other.m_Bits[i];
+        }
+
+        size_t Count() const { return static_cast<size_t>(std::count(m_Bits.begin(), m_Bits.end(), 1)); }
+
+        // Pixel bounds of a tile (edge tiles are smaller)
+        void TileRect(int col, int row, int& x, int& y, int& w, int& h) const {
+            x = col * m_TileSize; y = row * m_TileSize;
+            w = std::min(m_TileSize, m_Width - x); h = std::min(m_TileSize, m_Height - y);
+        }
+
+        // Marks the tiles where two tightly packed BGRA frames differ (existing marks are kept)
+        void Diff(const uint8_t* a, const uint8_t* b) {
+            if (a == b) return; // Repeated frame sharing its pixels
+            const size_t stride = static_cast<size_t>(m_Width) * 4;
+            for (int r = 0; r < m_Rows; r++) {
+                for (int c = 0; c < m_Cols; c++) {
+                    if (IsSet(c, r)) continue;
+                    int x, y, w, h; TileRect(c, r, x, y, w, h);
+                    const size_t off = y * stride + static_cast<size_t>(x) * 4;
+                    for (int row = 0; row < h; row++) {
+                        if (memcmp(a + off + row * stride, b + off + row * stride, static_cast<size_t>(w) * 4) != 0) { Mark(c, r); break; }
+                    }
+                }
+            }
+        }
+    };
+}
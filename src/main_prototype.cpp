@@ -8,7 +8,7 @@
 #include <windows.h>
 #include <dwmapi.h>
 #include <string>
-#include "RecorderEngine.hpp"
+#include "platform/Win32Platform.hpp"
 
 retrorec::RecorderEngine g_engine;
 HWND hToolbar, hOverlay;
@@ -20,6 +20,9 @@ HWND hToolbar, hOverlay;
 #define IDC_MOSAIC 5
 #define IDC_CLEAR 6
 #define IDC_RETRO 7
+#define IDC_HIDE_HINTS 8
+#define IDC_IGNORE_HINTS 9
+#define IDC_HALO 10
 
 LRESULT CALLBACK OverlayProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
     switch (message) {
@@ -32,7 +35,9 @@ LRESULT CALLBACK OverlayProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPar
         HPEN hmp = CreatePen(PS_DASH, 1, RGB(0, 0, 255)); HBRUSH hnb = (HBRUSH)GetStockObject(NULL_BRUSH);
         SelectObject(hdc, hmp); SelectObject(hdc, hnb);
         for (const auto& r : zones) Rectangle(hdc, r.x, r.y, r.x + r.w, r.y + r.h);
-        DeleteObject(hmp); EndPaint(hWnd, &ps);
+        HPEN hsp = CreatePen(PS_SOLID, 2, RGB(255, 140, 0)); SelectObject(hdc, hsp);
+        for (const auto& s : g_engine.getSuggestions()) Rectangle(hdc, s.rect.x, s.rect.y, s.rect.x + s.rect.w, s.rect.y + s.rect.h);
+        SelectObject(hdc, ho); DeleteObject(hmp); DeleteObject(hsp); EndPaint(hWnd, &ps);
     } break;
     case WM_NCHITTEST: return (g_engine.isPaintMode() || g_engine.isMosaicMode()) ? HTCLIENT : HTTRANSPARENT;
     case WM_LBUTTONDOWN:
@@ -52,6 +57,9 @@ LRESULT CALLBACK ToolbarProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPar
         CreateWindow("BUTTON", "Mosaic", WS_VISIBLE|WS_CHILD, 240, 10, 60, 30, hWnd, (HMENU)IDC_MOSAIC, 0, 0);
         CreateWindow("BUTTON", "Clear", WS_VISIBLE|WS_CHILD, 305, 10, 50, 30, hWnd, (HMENU)IDC_CLEAR, 0, 0);
         CreateWindow("BUTTON", "RetroFix", WS_VISIBLE|WS_CHILD, 360, 10, 75, 30, hWnd, (HMENU)IDC_RETRO, 0, 0);
+        CreateWindow("BUTTON", "Hide Hints", WS_VISIBLE|WS_CHILD, 445, 10, 80, 30, hWnd, (HMENU)IDC_HIDE_HINTS, 0, 0);
+        CreateWindow("BUTTON", "Ignore", WS_VISIBLE|WS_CHILD, 530, 10, 60, 30, hWnd, (HMENU)IDC_IGNORE_HINTS, 0, 0);
+        CreateWindow("BUTTON", "Halo", WS_VISIBLE|WS_CHILD, 595, 10, 50, 30, hWnd, (HMENU)IDC_HALO, 0, 0);
         SetTimer(hWnd, 1, 33, NULL); break;
     case WM_COMMAND:
         switch (LOWORD(wParam)) {
@@ -62,8 +70,16 @@ LRESULT CALLBACK ToolbarProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPar
         case IDC_MOSAIC: g_engine.toggleMosaicMode(); break;
         case IDC_CLEAR: g_engine.clearEffects(); break;
         case IDC_RETRO: g_engine.applyRetroactiveMosaic(); MessageBox(hWnd, "Retro-Mosaic Applied!", "RetroRec", MB_OK); break;
+        case IDC_HIDE_HINTS: g_engine.acceptSuggestions(); break;
+        case IDC_IGNORE_HINTS: g_engine.dismissSuggestions(); break;
+        case IDC_HALO: { auto cs = g_engine.getCursorStyle(); cs.Halo = !cs.Halo; g_engine.setCursorStyle(cs); } break;
         } break;
-    case WM_TIMER: InvalidateRect(hOverlay, NULL, TRUE); break;
+    case WM_TIMER: {
+        InvalidateRect(hOverlay, NULL, TRUE);
+        // The retro window changes with the memory budget, memory pressure and the load governor
+        static long long shown = -1; long long tenths = g_engine.retroWindow().count() / 100;
+        if (tenths != shown) { shown = tenths; std::string t = "Retro " + std::to_string(tenths / 10) + "." + std::to_string(tenths % 10) + "s"; SetWindowText(GetDlgItem(hWnd, IDC_RETRO), t.c_str()); }
+    } break;
     case WM_DESTROY: PostQuitMessage(0); break;
     default: return DefWindowProc(hWnd, message, wParam, lParam);
     }
@@ -75,13 +91,13 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int) {
     RegisterClassEx(&wc1);
     WNDCLASSEX wc2 = { sizeof(WNDCLASSEX), CS_HREDRAW|CS_VREDRAW, OverlayProc, 0,0, hInstance, 0, LoadCursor(0, IDC_ARROW), 0, 0, "OverlayClass", 0 };
     RegisterClassEx(&wc2);
-    int sw = GetSystemMetrics(SM_CXSCREEN), sh = GetSystemMetrics(SM_CYSCREEN), w = 460, h = 100;
+    int sw = GetSystemMetrics(SM_CXSCREEN), sh = GetSystemMetrics(SM_CYSCREEN), w = 670, h = 100;
     hToolbar = CreateWindowEx(WS_EX_TOPMOST, "ToolbarClass", "RetroRec V1.1", WS_OVERLAPPEDWINDOW & ~WS_MAXIMIZEBOX, (sw-w)/2, 100, w, h, 0, 0, hInstance, 0);
     ShowWindow(hToolbar, SW_SHOW);
     hOverlay = CreateWindowEx(WS_EX_TOPMOST|WS_EX_LAYERED|WS_EX_TOOLWINDOW, "OverlayClass", "", WS_POPUP, 0,0, sw, sh, hToolbar, 0, hInstance, 0);
     SetLayeredWindowAttributes(hOverlay, 0, 0, LWA_COLORKEY);
     ShowWindow(hOverlay, SW_SHOW);
-    g_engine.initialize();
-    MSG msg; while (GetMessage(&msg, 0,0,0)) { TranslateMessage(&msg); DispatchMessage(&msg); g_engine.captureFrame(); }
+    g_engine.initialize(); g_engine.arm(); // Encoders open now, so Rec starts writing the pre-roll immediately
+    MSG msg; while (GetMessage(&msg, 0,0,0)) { TranslateMessage(&msg); DispatchMessage(&msg); g_engine.captureFrame(); } // The 33 ms timer keeps messages coming; the engine drops calls faster than 30 fps
     return (int)msg.wParam;
 }
@@ -0,0 +1,147 @@
+// Windows front-end of the engine: Desktop Duplication sources, WASAPI loopback, the system cursor.
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <wrl/client.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "RecorderEngine.hpp"
+
+using Microsoft::WRL::ComPtr;
+
+namespace retrorec {
+
+    class AudioCapture {
+    public:
+        ComPtr<IAudioClient> audioClient;
+        ComPtr<IAudioCaptureClient> captureClient;
+        WAVEFORMATEX* pwfx = nullptr;
+        bool initialized = false;
+
+        bool init() {
+            CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+            ComPtr<IMMDeviceEnumerator> enumerator;
+            if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator)))) return false;
+            ComPtr<IMMDevice> device;
+            if (FAILED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device))) return false;
+            if (FAILED(device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, &audioClient))) return false;
+            audioClient->GetMixFormat(&pwfx);
+            if (FAILED(audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, 10000000, 0, pwfx, nullptr))) return false;
+            if (FAILED(audioClient->GetService(IID_PPV_ARGS(&captureClient)))) return false;
+            audioClient->Start();
+            initialized = true;
+            return true;
+        }
+        void read(std::vector<uint8_t>& buffer) {
+            if (!initialized) return;
+            UINT32 pktLen = 0; captureClient->GetNextPacketSize(&pktLen);
+            while (pktLen != 0) {
+                BYTE* pData; UINT32 nFrames; DWORD flags;
+                captureClient->GetBuffer(&pData, &nFrames, &flags, nullptr, nullptr);
+                if (nFrames > 0) buffer.insert(buffer.end(), pData, pData + (nFrames * pwfx->nBlockAlign));
+                captureClient->ReleaseBuffer(nFrames);
+                captureClient->GetNextPacketSize(&pktLen);
+            }
+        }
+        ~AudioCapture() { if (audioClient) audioClient->Stop(); if (pwfx) CoTaskMemFree(pwfx); }
+    };
+
+    // One monitor, captured through Desktop Duplication. All outputs share the engine's D3D device.
+    class DXGIOutputSource : public FrameSource {
+        ComPtr<ID3D11Device> d3d_device;
+        ComPtr<ID3D11DeviceContext> d3d_context;
+        ComPtr<IDXGIOutputDuplication> dxgi_duplication;
+        ComPtr<ID3D11Texture2D> staging_texture;
+        DXGI_OUTPUT_DESC output_desc;
+        std::string name;
+        int width = 0, height = 0;
+        CursorState cursor;                  // Desktop Duplication reports the pointer apart from the image
+        POINT pointer_pos{ 0, 0 };           // Top-left of the shape, output coordinates
+        std::vector<uint8_t> shape_buffer;
+
+    public:
+        bool init(ComPtr<ID3D11Device> dev, ComPtr<ID3D11DeviceContext> ctx, IDXGIOutput* out, int index) {
+            d3d_device = dev; d3d_context = ctx;
+            ComPtr<IDXGIOutput1> out1; if (FAILED(out->QueryInterface(IID_PPV_ARGS(&out1)))) return false;
+            if (FAILED(out1->DuplicateOutput(d3d_device.Get(), &dxgi_duplication))) return false;
+            out->GetDesc(&output_desc);
+            width = (output_desc.DesktopCoordinates.right - output_desc.DesktopCoordinates.left) & ~1;
+            height = (output_desc.DesktopCoordinates.bottom - output_desc.DesktopCoordinates.top) & ~1;
+            name = "Monitor" + std::to_string(index + 1);
+            return true;
+        }
+        std::string Name() const override { return name; }
+        int Width() const override { return width; }
+        int Height() const override { return height; }
+        int OriginX() const override { return output_desc.DesktopCoordinates.left; }
+        int OriginY() const override { return output_desc.DesktopCoordinates.top; }
+        CursorState Cursor() const override { return cursor; }
+
+        bool Grab(uint8_t* dst) override {
+            DXGI_OUTDUPL_FRAME_INFO fi; ComPtr<IDXGIResource> res;
+            if (FAILED(dxgi_duplication->AcquireNextFrame(0, &fi, &res))) return false;
+            if (fi.LastMouseUpdateTime.QuadPart != 0) { cursor.Visible = fi.PointerPosition.Visible != 0; pointer_pos = fi.PointerPosition.Position; }
+            if (fi.PointerShapeBufferSize > 0) {
+                shape_buffer.resize(fi.PointerShapeBufferSize); UINT req = 0; DXGI_OUTDUPL_POINTER_SHAPE_INFO si;
+                if (SUCCEEDED(dxgi_duplication->GetFramePointerShape((UINT)shape_buffer.size(), shape_buffer.data(), &req, &si)))
+                    cursor.Shape = CursorShape::FromPointerShape((int)si.Type, (int)si.Width, (int)si.Height, (int)si.Pitch, shape_buffer.data(), (int)si.HotSpot.x, (int)si.HotSpot.y);
+            }
+            if (cursor.Shape) { cursor.X = (int)pointer_pos.x + cursor.Shape->HotX; cursor.Y = (int)pointer_pos.y + cursor.Shape->HotY; }
+            if (fi.LastPresentTime.QuadPart == 0) { dxgi_duplication->ReleaseFrame(); return false; } // Only the pointer changed
+            ComPtr<ID3D11Texture2D> tex; res.As(&tex);
+            if (!staging_texture) { D3D11_TEXTURE2D_DESC d; tex->GetDesc(&d); d.Usage = D3D11_USAGE_STAGING; d.CPUAccessFlags = D3D11_CPU_ACCESS_READ; d.BindFlags = 0; d.MiscFlags = 0; d3d_device->CreateTexture2D(&d, nullptr, &staging_texture); }
+            d3d_context->CopyResource(staging_texture.Get(), tex.Get()); dxgi_duplication->ReleaseFrame();
+            D3D11_MAPPED_SUBRESOURCE map; if (FAILED(d3d_context->Map(staging_texture.Get(), 0, D3D11_MAP_READ, 0, &map))) return false;
+            if (map.RowPitch == (UINT)width * 4) memcpy(dst, map.pData, (size_t)width * height * 4);
+            else for (int y=0; y<height; y++) memcpy(dst + (size_t)y*width*4, (uint8_t*)map.pData + (size_t)y*map.RowPitch, (size_t)width*4);
+            d3d_context->Unmap(staging_texture.Get(), 0);
+            return true;
+        }
+    };
+
+
+    // Source policy for Windows: every monitor of the default adapter (sharing one D3D device), the system cursor, loopback audio.
+    class Win32Platform {
+        ComPtr<ID3D11Device> d3d_device;
+        ComPtr<ID3D11DeviceContext> d3d_context;
+        AudioCapture audio_cap;
+        HANDLE low_memory = nullptr; // Signaled by the memory manager while available physical memory is low
+
+    public:
+        ~Win32Platform() { if (low_memory) CloseHandle(low_memory); }
+
+        bool openSources(std::vector<std::unique_ptr<FrameSource>>& out) {
+            if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, &d3d_device, nullptr, &d3d_context))) return false;
+            ComPtr<IDXGIDevice> dxgi_dev; d3d_device.As(&dxgi_dev);
+            ComPtr<IDXGIAdapter> dxgi_adp; dxgi_dev->GetAdapter(&dxgi_adp);
+            ComPtr<IDXGIOutput> dxgi_out;
+            for (UINT i = 0; dxgi_adp->EnumOutputs(i, &dxgi_out) != DXGI_ERROR_NOT_FOUND; i++) {
+                auto src = std::make_unique<DXGIOutputSource>();
+                if (src->init(d3d_device, d3d_context, dxgi_out.Get(), (int)i)) out.push_back(std::move(src));
+                dxgi_out.Reset();
+            }
+            return true;
+        }
+        bool cursorPosition(int& x, int& y) { POINT p; if (!GetCursorPos(&p)) return false; x = (int)p.x; y = (int)p.y; return true; }
+        bool openAudio() { return audio_cap.init(); }
+        void readAudio(std::vector<uint8_t>& buffer) { audio_cap.read(buffer); }
+        bool memoryLow() {
+            if (!low_memory) low_memory = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+            BOOL low = FALSE;
+            return low_memory && QueryMemoryResourceNotification(low_memory, &low) && low;
+        }
+    };
+
+    // Desktop Duplication delivers BGRA
+    using RecorderEngine = BasicRecorderEngine<Win32Platform, Bgra, MosaicMask<>, FFmpegSink>;
+}
@@ -0,0 +1,177 @@
+// Steady state allocates nothing: capture, masking, detection, conversion and region-of-interest hints run on recycled memory.
+// Counts every heap allocation of the process (all threads) by interposing the C allocator, so this is an executable of its own.
+// What libavcodec allocates inside avcodec_send_frame / x264 (frame references, ROI offset tables, packets) is not covered:
+// the sink here stops where the encoder would start.
+#include "Check.hpp"
+#include "EngineFixtures.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+using namespace retrorec;
+using namespace retrorec::test;
+
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace {
+    std::atomic<bool> g_Counting{false};
+    std::atomic<uint64_t> g_Allocations{0};
+    inline void CountAllocation() { if (g_Counting.load(std::memory_order_relaxed)) g_Allocations.fetch_add(1, std::memory_order_relaxed); }
+}
+
+extern "C" {
+    void* malloc(size_t n) { CountAllocation(); return __libc_malloc(n); }
+    void* calloc(size_t n, size_t size) { CountAllocation(); return __libc_calloc(n, size); }
+    void* realloc(void* p, size_t n) { CountAllocation(); return __libc_realloc(p, n); }
+    void* memalign(size_t align, size_t n) { CountAllocation(); return __libc_memalign(align, n); }
+    void* aligned_alloc(size_t align, size_t n) { CountAllocation(); return __libc_memalign(align, n); }
+    int posix_memalign(void** out, size_t align, size_t n) { CountAllocation(); void* p = __libc_memalign(align, n); if (!p) return ENOMEM; *out = p; return 0; }
+    void free(void* p) { __libc_free(p); }
+}
+#define RETROREC_COUNTS_ALLOCATIONS 1
+#endif
+
+namespace {
+    // A platform with loopback audio: every tick appends one tick of 48 kHz stereo float PCM.
+    struct PcmPlatform : HeadlessPlatform {
+        bool openAudio() { return true; }
+        void readAudio(std::vector<uint8_t>& pcm) { pcm.resize(pcm.size() + 1600 * 8, 0); }
+    };
+
+    // Wants region-of-interest hints and checks they arrive; keeps nothing.
+    class HintCheckingSink : public NullSink {
+        std::atomic<uint64_t> hinted{0};
+        std::atomic<size_t> audio_bytes{0};
+    public:
+        bool wantsRegionsOfInterest() const { return true; }
+        void push(size_t s, const AVFrameRef& yuv) { if (av_frame_get_side_data(yuv.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST)) hinted++; NullSink::push(s, yuv); }
+        void writeAudio(const std::vector<uint8_t>& pcm) { audio_bytes = pcm.size(); }
+        uint64_t framesHinted() const { return hinted; }
+        size_t lastAudioBytes() const { return audio_bytes; }
+    };
+
+    using CountedEngine = BasicRecorderEngine<PcmPlatform, Bgra, MosaicMask<8>, HintCheckingSink>;
+
+    // An encoder that falls behind. Holding: keeps every frame it is given (its queue never drains). Stalled: push() blocks,
+    // so the source worker stops and the ring backs up.
+    class LaggingSink : public NullSink {
+        std::mutex mutex;
+        std::condition_variable resume;
+        std::vector<AVFrameRef> held;
+        bool holding = false, stalled = false;
+    public:
+        LaggingSink() { held.reserve(1024); }
+        void push(size_t s, const AVFrameRef& yuv) {
+            std::unique_lock<std::mutex> l(mutex);
+            resume.wait(l, [&] { return !stalled; });
+            if (holding) held.push_back(yuv);
+            NullSink::push(s, yuv);
+        }
+        void Lag(bool on) {
+            { std::lock_guard<std::mutex> l(mutex); holding = stalled = on; if (!on) held.clear(); }
+            resume.notify_all();
+        }
+    };
+
+    using LaggingEngine = BasicRecorderEngine<HeadlessPlatform, Bgra, MosaicMask<8>, LaggingSink>;
+
+    // Typing: one more glyph-sized block per frame, in a line that starts over
+    std::vector<Pixels> TypingFrames(int w, int h, int n) {
+        std::vector<Pixels> frames;
+        Pixels page = SolidFrame(w, h, 240, 240, 240);
+        for (int i = 0; i < n; i++) {
+            for (int y = 40; y < 56; y++) for (int x = 20 + i * 10; x < 28 + i * 10; x++) { uint8_t* p = PixelAt(page, w, x, y); p[0] = p[1] = p[2] = 30; }
+            frames.push_back(page);
+        }
+        return frames;
+    }
+
+    uint64_t AllocationsDuring(const std::function<void()>& work) {
+#ifdef RETROREC_COUNTS_ALLOCATIONS
+        g_Allocations = 0; g_Counting = true;
+        work();
+        g_Counting = false;
+        return g_Allocations;
+#else
+        work();
+        return 0;
+#endif
+    }
+}
+
+TEST_CASE(SteadyStateAllocatesNothing) {
+#ifndef RETROREC_COUNTS_ALLOCATIONS
+    std::cout << "  (allocator not interposed on this platform: counting skipped)" << std::endl;
+#endif
+    const int w = 320, h = 240;
+    CountedEngine e;
+    auto owned = std::make_unique<ScriptedSource>(w, h);
+    ScriptedSource& src = *owned;
+    CHECK(e.addSource(std::move(owned)));
+    e.setHistoryBudget(0, 0.3);
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    e.addMosaic(200, 100, 64, 48); // A live mask: its region goes into every frame's hints
+    CHECK(e.startRecording());
+
+    const std::vector<Pixels> typing = TypingFrames(w, h, 24);
+    int tick = 0;
+    auto type = [&](int ticks) { for (int k = 0; k < ticks; k++, tick++) { src.Show(typing[tick % typing.size()]); src.MoveCursor(100 + tick % 50, 120); Tick(e); } };
+    auto point = [&](int ticks) { for (int k = 0; k < ticks; k++, tick++) { src.MoveCursor(100 + tick % 50, 150); Tick(e); } }; // Repeats
+
+    type(40); // Warm-up: pools, slots, ring storage, detector scratch and side data reach their steady size
+    uint64_t typing_allocs = AllocationsDuring([&] { type(45); });
+    point(20); // Until the ring cycled once, repeats of the new picture take buffer references (and the first ones new shells)
+    uint64_t pointing_allocs = AllocationsDuring([&] { point(30); });
+    e.stopRecording();
+
+    std::cout << "  allocations: typing " << typing_allocs << ", pointing " << pointing_allocs << std::endl;
+    CHECK_EQ(typing_allocs, uint64_t(0));
+    CHECK_EQ(pointing_allocs, uint64_t(0));
+    const HintCheckingSink& sink = e.getSink();
+    CHECK(sink.framesReceived() >= 100);
+    CHECK_EQ(sink.framesHinted(), sink.framesReceived());
+    CHECK_EQ(sink.lastAudioBytes(), size_t(1600 * 8));
+}
+
+// A lagging encoder costs frames, not memory: the frame pool stops at the history plus a small backlog and the encoder slots at
+// what the renditions may queue. The first lag grows both to their caps; a second, longer one must not allocate any further.
+TEST_CASE(LaggingEncoderDropsInsteadOfAllocating) {
+    const int w = 320, h = 240;
+    LaggingEngine e;
+    auto owned = std::make_unique<ScriptedSource>(w, h);
+    ScriptedSource& src = *owned;
+    CHECK(e.addSource(std::move(owned)));
+    e.setHistoryBudget(0, 0.3);
+    e.setLoadGovernor(false); // Keeps the ladder (and its change log) out of it: this is about the caps
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+
+    const std::vector<Pixels> typing = TypingFrames(w, h, 24);
+    int tick = 0;
+    auto type = [&](int ticks) { for (int k = 0; k < ticks; k++, tick++) { src.Show(typing[tick % typing.size()]); Tick(e); } };
+    LaggingSink& sink = e.getSink();
+
+    type(40);
+    sink.Lag(true); type(40); sink.Lag(false); type(20); // Warm-up: pool, encoder slots and ring storage reach their caps
+    int64_t dropped_before = e.loadStats().dropped_frames;
+    uint64_t lag_allocs = AllocationsDuring([&] { sink.Lag(true); type(80); sink.Lag(false); type(20); });
+    e.stopRecording();
+
+    std::cout << "  allocations while lagging: " << lag_allocs << ", dropped " << e.loadStats().dropped_frames - dropped_before << std::endl;
+    CHECK_EQ(lag_allocs, uint64_t(0));
+    CHECK(e.loadStats().dropped_frames > dropped_before);
+}
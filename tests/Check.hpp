@@ -0,0 +1,45 @@
+/**
+ * RetroRec - Test Harness (The "Referee")
+ * Plain executables, no framework: every TEST_CASE registers itself, RunAll() runs them in order
+ * (or only those whose name contains argv[1]) and the exit code tells CTest whether all CHECKs held.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace retrorec::test {
+
+    struct Case { const char* name; void (*fn)(); };
+    inline std::vector<Case>& Cases() { static std::vector<Case> cases; return cases; }
+    inline int& Failures() { static int n = 0; return n; }
+    struct Register { Register(const char* name, void (*fn)()) { Cases().push_back({ name, fn }); } };
+
+    inline int RunAll(int argc, char** argv) {
+        int failed_cases = 0;
+        for (const auto& c : Cases()) {
+            if (argc > 1 && !strstr(c.name, argv[1])) continue;
+            const int before = Failures();
+            std::cout << "[ RUN  ] " << c.name << std::endl;
+            c.fn();
+            const bool ok = Failures() == before;
+            failed_cases += !ok;
+            std::cout << (ok ? "[  OK  ] " : "[ FAIL ] ") << c.name << std::endl;
+        }
+        std::cout << (failed_cases ? "FAILED: " : "PASSED: ") << failed_cases << " failing case(s)" << std::endl;
+        return failed_cases ? 1 : 0;
+    }
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const retrorec::test::Register name##_registered(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; retrorec::test::Failures()++; } } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { auto va_ = (a); auto vb_ = (b); if (!(va_ == vb_)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #a ", " #b ") failed: " << va_ << " != " << vb_ << std::endl; retrorec::test::Failures()++; } } while (0)
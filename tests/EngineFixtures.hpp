@@ -0,0 +1,97 @@
+// Engine-level fixtures: a source the test drives frame by frame, and a sink that keeps what it was given.
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "RecorderEngine.hpp"
+#include "TestFrames.hpp"
+
+namespace retrorec::test {
+
+    // Delivers whatever the test put in Pixels; Grab() reports "new image" only after Show(). The cursor (no shape) is
+    // moved with MoveCursor(), which is enough for the engine to repeat the previous frame.
+    class ScriptedSource : public RetroRec::Core::FrameSource {
+        int m_Width, m_Height;
+        Pixels m_Pixels;
+        bool m_Fresh = false;
+        RetroRec::Core::CursorState m_Cursor;
+
+    public:
+        ScriptedSource(int w, int h) : m_Width(w), m_Height(h), m_Pixels(static_cast<size_t>(w) * h * 4, 0) {}
+        std::string Name() const override { return "Scripted"; }
+        int Width() const override { return m_Width; }
+        int Height() const override { return m_Height; }
+        bool Grab(uint8_t* dst) override {
+            memcpy(dst, m_Pixels.data(), m_Pixels.size()); // Like a real source: the buffer always gets the current image
+            bool fresh = m_Fresh; m_Fresh = false;
+            return fresh;
+        }
+        RetroRec::Core::CursorState Cursor() const override { return m_Cursor; }
+
+        void Show(const Pixels& p) { m_Pixels = p; m_Fresh = true; }
+        void MoveCursor(int x, int y) { m_Cursor.Visible = true; m_Cursor.X = x; m_Cursor.Y = y; }
+    };
+
+    // Keeps a copy of the luma plane of every frame pushed (one source). Encoder-free, so it runs with any FFmpeg build.
+    class CaptureSink {
+        std::vector<Rendition> prepared;
+        mutable std::mutex mutex;
+        std::vector<Pixels> luma;
+        std::vector<int64_t> pts;
+        size_t hinted = 0;
+
+    public:
+        bool want_rois = false;
+
+        bool prepare(const std::vector<SinkSource>& srcs, const std::vector<Rendition>& renditions, int) {
+            prepared = renditions.empty() ? std::vector<Rendition>{ Rendition{} } : renditions;
+            return !srcs.empty();
+        }
+        void release() { prepared.clear(); }
+        const std::vector<Rendition>& renditions() const { return prepared; }
+        bool wantsRegionsOfInterest() const { return want_rois; }
+        const std::vector<WrittenTrack>& writtenTracks() const { static const std::vector<WrittenTrack> none; return none; }
+        bool start(OutputLayout, std::chrono::steady_clock::time_point, int64_t) { return !prepared.empty(); }
+        void push(size_t, const AVFrameRef& yuv) {
+            Pixels y(static_cast<size_t>(yuv->width) * yuv->height);
+            for (int r = 0; r < yuv->height; r++) memcpy(y.data() + static_cast<size_t>(r) * yuv->width, yuv->data[0] + static_cast<size_t>(r) * yuv->linesize[0], yuv->width);
+            std::lock_guard<std::mutex> l(mutex);
+            luma.push_back(std::move(y)); pts.push_back(yuv->pts);
+            if (av_frame_get_side_data(yuv.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST)) hinted++;
+        }
+        void writeAudio(const std::vector<uint8_t>&) {}
+        void finish() {}
+        std::chrono::microseconds startLatency() const { return std::chrono::microseconds(0); }
+        double encodeLoad() { return 0; }
+        int queueDepth() { return 0; }
+        int64_t droppedFrames() const { return 0; }
+        void setQualityOffset(int) {}
+
+        size_t Count() const { std::lock_guard<std::mutex> l(mutex); return luma.size(); }
+        Pixels Luma(size_t i) const { std::lock_guard<std::mutex> l(mutex); return luma[i]; }
+        size_t Hinted() const { std::lock_guard<std::mutex> l(mutex); return hinted; }
+
+        // Waits (bounded) until the workers delivered `n` frames
+        bool WaitFor(size_t n, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) const {
+            auto until = std::chrono::steady_clock::now() + timeout;
+            while (Count() < n) { if (std::chrono::steady_clock::now() > until) return false; std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+            return true;
+        }
+    };
+
+    // True if every `cell` x `cell` block of the rect (anchored at its top-left) is flat in a w-wide luma plane: what a mosaic leaves.
+    inline bool LumaIsMosaic(const Pixels& y, int w, int rx, int ry, int rw, int rh, int cell) {
+        for (int cy = ry; cy < ry + rh; cy += cell)
+            for (int cx = rx; cx < rx + rw; cx += cell) {
+                const uint8_t v = y[static_cast<size_t>(cy) * w + cx];
+                for (int py = cy; py < std::min(cy + cell, ry + rh); py++)
+                    for (int px = cx; px < std::min(cx + cell, rx + rw); px++) if (y[static_cast<size_t>(py) * w + px] != v) return false;
+            }
+        return true;
+    }
+
+    template <class Engine>
+    void Tick(Engine& e, std::chrono::milliseconds gap = std::chrono::milliseconds(34)) { e.captureFrame(); std::this_thread::sleep_for(gap); }
+}
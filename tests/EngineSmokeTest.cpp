@@ -0,0 +1,228 @@
+// Headless engine end to end: SyntheticSource -> ring -> masks -> conversion -> NullSink. Needs FFmpeg (frames, swscale), not an encoder.
+#include "Check.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RecorderEngine.hpp"
+
+using namespace retrorec;
+using RetroRec::Core::SyntheticSource;
+
+namespace {
+    using HeadlessEngine = BasicRecorderEngine<HeadlessPlatform, Rgba, MosaicMask<8>, NullSink>;
+
+    template <class Engine>
+    void Ticks(Engine& e, int n) {
+        for (int i = 0; i < n; i++) { e.captureFrame(); std::this_thread::sleep_for(std::chrono::milliseconds(34)); }
+    }
+}
+
+TEST_CASE(EngineNeedsASource) {
+    HeadlessEngine e;
+    CHECK(!e.initialize());
+    CHECK(!e.startRecording());
+}
+
+TEST_CASE(EngineRecordsPreRollAndLiveFrames) {
+    HeadlessEngine e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 320, 200)));
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    CHECK(e.isArmed());
+    Ticks(e, 10); // Pre-roll: all of it fits in the 3 s window
+    CHECK(e.startRecording());
+    Ticks(e, 10);
+    e.addMosaic(20, 20, 64, 48);
+    e.applyRetroactiveMosaic();
+    Ticks(e, 5);
+    e.stopRecording();
+    CHECK(!e.isRecording());
+    CHECK_EQ(e.getSink().framesReceived(), uint64_t(25));
+    CHECK(e.isArmed()); // Re-armed right after Stop
+
+    // Second recording: only what was captured since
+    Ticks(e, 3);
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+    Ticks(e, 4);
+    e.stopRecording();
+    CHECK_EQ(e.getSink().framesReceived(), uint64_t(29));
+    CHECK_EQ(e.loadStats().level, 0);
+}
+
+// Stop writes out the ring but keeps it as history: a Rec pressed right after Stop still starts with the last frames.
+TEST_CASE(RecRightAfterStopHasPreRoll) {
+    HeadlessEngine e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 320, 200)));
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+    Ticks(e, 10);
+    e.stopRecording();
+    CHECK_EQ(e.getSink().framesReceived(), uint64_t(10));
+
+    e.setPreRoll(3);
+    CHECK(e.startRecording()); // No capture since Stop: the pre-roll is the first recording's frames
+    Ticks(e, 2);
+    e.stopRecording();
+    CHECK_EQ(e.getSink().framesReceived(), uint64_t(10 + 10 + 2));
+}
+
+TEST_CASE(EngineScrubbingStrip) {
+    HeadlessEngine e;
+    e.addSource(std::make_unique<SyntheticSource>("Synthetic", 256, 128));
+    CHECK(e.initialize());
+    Ticks(e, 12);
+    auto strip = e.timelineStrip(0, 6, std::chrono::milliseconds(400));
+    CHECK(!strip.empty());
+    for (size_t i = 1; i < strip.size(); i++) CHECK(strip[i].timestamp > strip[i - 1].timestamp);
+    if (!strip.empty()) {
+        CHECK(strip[0].image && strip[0].image->Width == 16 && strip[0].image->Height == 8);
+        auto preview = e.framePreview(0, strip.back().sequence);
+        CHECK(preview && preview->Width == 64 && preview->Height == 32);
+    }
+    auto window = e.retroWindow().count(); // Ring still filling: as old as its oldest frame (12 ticks of ~34 ms)
+    CHECK(window >= 350 && window < 1500);
+}
+
+// The host may call captureFrame() far more often than 30 times a second (the prototype calls it after every window message):
+// extra calls capture nothing, and once the ring is full the window follows the rate frames actually arrive at.
+TEST_CASE(CaptureIsRateLimitedAndWindowFollowsRate) {
+    HeadlessEngine e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 64, 48)));
+    CHECK(e.initialize());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < end) { e.captureFrame(); std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    e.stopRecording();
+    auto frames = e.getSink().framesReceived();
+    CHECK(frames >= 25 && frames <= 35);
+
+    e.setHistoryBudget(0, 0.3); // 9 frames at 30 fps
+    for (int i = 0; i < 20; i++) { e.captureFrame(); std::this_thread::sleep_for(std::chrono::milliseconds(68)); }
+    auto window = e.retroWindow().count(); // 9 frames ~68 ms apart, not 300 ms
+    CHECK(window >= 500 && window < 1000);
+}
+
+// An encoder that cannot be opened (here: a preset x264 does not know) must fail arm and Rec, not crash in start().
+TEST_CASE(EncoderThatCannotOpenFailsArm) {
+    Rendition bad; bad.preset = "no-such-preset";
+    FFmpegSink sink;
+    CHECK(!sink.prepare({ { "Synthetic", 64, 48 } }, { bad }, 30));
+    CHECK(sink.renditions().empty());
+
+    BasicRecorderEngine<HeadlessPlatform, Rgba, MosaicMask<8>, FFmpegSink> e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 64, 48)));
+    CHECK(e.initialize());
+    CHECK(!e.arm({ bad }));
+    CHECK(!e.isArmed());
+    CHECK(!e.startRecording({ bad }));
+    CHECK(!e.isRecording());
+}
+
+// A file that cannot be created fails Rec and leaves the encoders armed for the next try. Needs libx264 to get that far.
+TEST_CASE(UnwritableFileFailsRec) {
+    Rendition r; r.file = "/nonexistent-retrorec-dir/out.mp4";
+    BasicRecorderEngine<HeadlessPlatform, Rgba, MosaicMask<8>, FFmpegSink> e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 64, 48)));
+    CHECK(e.initialize());
+    if (!e.arm({ r })) { std::cout << "  (no H.264 encoder in this FFmpeg: skipped)" << std::endl; return; }
+    CHECK(!e.startRecording());
+    CHECK(!e.isRecording());
+    CHECK(e.isArmed());
+    CHECK(e.getSink().writtenTracks().empty());
+}
+
+// Two renditions never write the same file: explicit duplicates ("a" and "a.mp4") fail prepare, derived names of renditions
+// that come out the same size get the rendition index. The second half needs libx264.
+TEST_CASE(RenditionsNeverShareAFile) {
+    Rendition a; a.file = "retrorec_dup";
+    Rendition b = a; b.file += ".mp4"; b.crf = 30;
+    FFmpegSink sink;
+    CHECK(!sink.prepare({ { "Synthetic", 64, 48 } }, { a, b }, 30));
+    CHECK(sink.renditions().empty());
+
+    Rendition full, small; small.width = 32;
+    Rendition small_hq = small; small_hq.crf = 18;
+    if (!sink.prepare({ { "Synthetic", 64, 48 } }, { full, small, small_hq }, 30)) { std::cout << "  (no H.264 encoder in this FFmpeg: skipped)" << std::endl; return; }
+    CHECK(sink.start(OutputLayout::FilePerSource, std::chrono::steady_clock::now(), 0));
+    sink.finish();
+    std::vector<std::string> paths;
+    for (const auto& t : sink.writtenTracks()) paths.push_back(t.path);
+    CHECK_EQ(paths.size(), size_t(3));
+    std::sort(paths.begin(), paths.end());
+    CHECK(std::unique(paths.begin(), paths.end()) == paths.end());
+    for (const auto& p : paths) std::remove(p.c_str());
+}
+
+namespace {
+    // An encoder starved by a CPU hog: every frame costs `burn_us` of spinning, and encodeLoad() reports the busy share.
+    class CpuHogSink : public NullSink {
+        std::atomic<int64_t> busy_us{0};
+        int64_t sampled_busy_us = 0;
+        std::chrono::steady_clock::time_point sampled = std::chrono::steady_clock::now();
+    public:
+        std::atomic<int> burn_us{0};
+        void push(size_t s, const AVFrameRef& yuv) {
+            auto t0 = std::chrono::steady_clock::now();
+            while (std::chrono::steady_clock::now() - t0 < std::chrono::microseconds(burn_us.load())) {}
+            busy_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+            NullSink::push(s, yuv);
+        }
+        double encodeLoad() {
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(now - sampled).count();
+            int64_t busy = busy_us.load();
+            double load = elapsed > 0 ? (busy - sampled_busy_us) / elapsed : 0;
+            sampled = now; sampled_busy_us = busy;
+            return load;
+        }
+    };
+}
+
+// The whole ladder under a CPU hog (spinning threads plus an encoder that cannot keep up), then back down while idle:
+// levels must not stick to the next recording, and the idle re-arm must pick up the next-arm rung both ways.
+TEST_CASE(GovernorClimbsUnderCpuHogAndDecaysWhileIdle) {
+    BasicRecorderEngine<HeadlessPlatform, Rgba, MosaicMask<8>, CpuHogSink> e;
+    CHECK(e.addSource(std::make_unique<SyntheticSource>("Synthetic", 160, 120)));
+    e.setSensitiveDetection(false);
+    e.setHistoryBudget(0, 0.5);
+    RetroRec::Core::LoadGovernor::Config fast; // Same logic, test-sized hold times
+    fast.UpHoldUs = 500000; fast.DownHoldUs = 500000; fast.CooldownUs = 300000; // Samples come every 250 ms
+    e.setLoadGovernorConfig(fast);
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+
+    std::atomic<bool> hogging{true};
+    std::vector<std::thread> hogs;
+    for (unsigned i = 0; i < (std::max)(1u, std::thread::hardware_concurrency()); i++) hogs.emplace_back([&] { while (hogging) {} });
+    e.getSink().burn_us = 60000; // Two capture ticks per frame: even 1/3 fps is too much
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (e.loadStats().level < 6 && std::chrono::steady_clock::now() < deadline) Ticks(e, 1);
+    hogging = false;
+    for (auto& t : hogs) t.join();
+    e.getSink().burn_us = 0;
+    const auto climbed = e.loadStats();
+    CHECK_EQ(climbed.level, 6);
+    CHECK(climbed.changes.size() >= 6);
+    e.stopRecording();
+    CHECK(e.isArmed());
+    CHECK(!e.getSink().renditions().empty() && e.getSink().renditions()[0].downscale == 2); // Re-armed with the next-arm rung
+
+    // Idle: the encoders do nothing, so every rung clears and the level decays to 0 without a recording
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (e.loadStats().level > 0 && std::chrono::steady_clock::now() < deadline) Ticks(e, 1);
+    CHECK_EQ(e.loadStats().level, 0);
+    CHECK(e.isArmed());
+    CHECK(!e.getSink().renditions().empty() && e.getSink().renditions()[0].downscale == 1); // Re-armed at full size while idle
+}
@@ -0,0 +1,105 @@
+#include "Check.hpp"
+#include "TestFrames.hpp"
+
+#include <algorithm>
+
+#include "core/IncrementalConverter.hpp"
+
+using RetroRec::Core::IncrementalConverter;
+using RetroRec::Core::TileMap;
+using RetroRec::Core::Bgra;
+using RetroRec::Core::Rgba;
+using namespace retrorec::test;
+
+namespace {
+    // YUV420P planes with padded strides, like an AVFrame
+    struct Planes {
+        int stride[3];
+        std::vector<uint8_t> plane[3];
+        uint8_t* data[3];
+        Planes(int w, int h) {
+            stride[0] = (w + 31) & ~31; stride[1] = stride[2] = ((w / 2) + 31) & ~31;
+            for (int p = 0; p < 3; p++) { plane[p].assign(static_cast<size_t>(stride[p]) * (p ? h / 2 : h), 0); data[p] = plane[p].data(); }
+        }
+        bool SameAs(const Planes& o, int w, int h) const {
+            for (int p = 0; p < 3; p++) {
+                const int pw = p ? w / 2 : w, ph = p ? h / 2 : h;
+                for (int y = 0; y < ph; y++) if (memcmp(data[p] + y * stride[p], o.data[p] + y * o.stride[p], pw) != 0) return false;
+            }
+            return true;
+        }
+    };
+
+    template <class Pixel = Bgra>
+    Planes FullConvert(const Pixels& px, int w, int h) {
+        Planes out(w, h);
+        IncrementalConverter::ConvertRect<Pixel>(px.data(), static_cast<size_t>(w) * 4, out.data, out.stride, 0, 0, w, h);
+        return out;
+    }
+}
+
+TEST_CASE(ConverterKnownColors) {
+    Planes white = FullConvert(SolidFrame(4, 4, 255, 255, 255), 4, 4);
+    CHECK_EQ(int(white.data[0][0]), 235); CHECK_EQ(int(white.data[1][0]), 128); CHECK_EQ(int(white.data[2][0]), 128);
+    Planes black = FullConvert(SolidFrame(4, 4, 0, 0, 0), 4, 4);
+    CHECK_EQ(int(black.data[0][0]), 16); CHECK_EQ(int(black.data[1][0]), 128); CHECK_EQ(int(black.data[2][0]), 128);
+    Planes red = FullConvert(SolidFrame(4, 4, 0, 0, 255), 4, 4); // BGRA
+    CHECK_EQ(int(red.data[0][0]), 82); CHECK_EQ(int(red.data[1][0]), 90); CHECK_EQ(int(red.data[2][0]), 240);
+}
+
+// The SIMD path must give the scalar formula's exact bytes (odd widths end in the scalar tail).
+TEST_CASE(ConverterMatchesReferenceFormula) {
+    const int w = 38, h = 12;
+    const Pixels px = NoiseFrame(w, h, 5);
+    Planes out = FullConvert(px, w, h);
+    bool same = true;
+    for (int y = 0; y < h; y += 2)
+        for (int x = 0; x < w; x += 2) {
+            int sb = 0, sg = 0, sr = 0;
+            for (int k = 0; k < 4; k++) {
+                const uint8_t* p = px.data() + (static_cast<size_t>(y + k / 2) * w + x + (k & 1)) * 4; // BGRA
+                const int luma = ((66 * p[2] + 129 * p[1] + 25 * p[0] + 128) >> 8) + 16;
+                same = same && out.data[0][(y + k / 2) * out.stride[0] + x + (k & 1)] == luma;
+                sb += p[0]; sg += p[1]; sr += p[2];
+            }
+            sb = (sb + 2) >> 2; sg = (sg + 2) >> 2; sr = (sr + 2) >> 2;
+            const int u = std::clamp(((-38 * sr - 74 * sg + 112 * sb + 128) >> 8) + 128, 0, 255), v = std::clamp(((112 * sr - 94 * sg - 18 * sb + 128) >> 8) + 128, 0, 255);
+            same = same && out.data[1][(y / 2) * out.stride[1] + x / 2] == u && out.data[2][(y / 2) * out.stride[2] + x / 2] == v;
+        }
+    CHECK(same);
+}
+
+TEST_CASE(ConverterPixelLayoutsAgree) {
+    const int w = 34, h = 18;
+    Pixels bgra = NoiseFrame(w, h, 7), rgba = bgra;
+    for (size_t i = 0; i < rgba.size(); i += 4) std::swap(rgba[i], rgba[i + 2]);
+    CHECK(FullConvert<Bgra>(bgra, w, h).SameAs(FullConvert<Rgba>(rgba, w, h), w, h));
+}
+
+// Two slots taking turns, like the encoder's rotating frames: each one is brought up to date from
+// whatever version it holds, and must end up identical to a full conversion of the current frame.
+TEST_CASE(ConverterIncrementalMatchesFullConversion) {
+    const int w = 100, h = 66, block = 16;
+    IncrementalConverter conv(w, h, block);
+    TileMap dirty(w, h, block);
+    Planes slots[2] = { Planes(w, h), Planes(w, h) };
+    uint64_t versions[2] = { 0, 0 };
+    Pixels prev, cur = NoiseFrame(w, h, 1);
+    for (int frame = 0; frame < 12; frame++) {
+        if (frame > 0) {
+            prev = cur;
+            // A few small edits (typing) and, every 5th frame, a bigger region
+            for (int k = 0; k < 3; k++) { int x = (frame * 37 + k * 23) % w, y = (frame * 13 + k * 29) % h; PixelAt(cur, w, x, y)[k] ^= 0x5A; }
+            if (frame % 5 == 0) { Pixels n = NoiseFrame(w, h, frame); for (int y = 10; y < 40; y++) memcpy(PixelAt(cur, w, 0, y), PixelAt(n, w, 0, y), 60 * 4); }
+            dirty.Clear(); dirty.Diff(prev.data(), cur.data());
+            conv.Advance(&dirty);
+        } else conv.Advance(nullptr);
+        const int s = frame & 1;
+        const size_t stale = conv.StaleBlocks(versions[s]);
+        CHECK_EQ(conv.Update(cur.data(), slots[s].data, slots[s].stride, versions[s]), stale);
+        versions[s] = conv.Version();
+        CHECK(slots[s].SameAs(FullConvert(cur, w, h), w, h));
+    }
+    CHECK_EQ(conv.StaleBlocks(0), conv.BlockCount());
+    CHECK_EQ(conv.StaleBlocks(conv.Version()), size_t(0));
+}
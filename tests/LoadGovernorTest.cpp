@@ -0,0 +1,77 @@
+#include "Check.hpp"
+
+#include "core/LoadGovernor.hpp"
+
+using RetroRec::Core::LoadGovernor;
+using RetroRec::Core::LoadSample;
+
+namespace {
+    constexpr int64_t MS = 1000;
+    LoadSample Busy() { LoadSample s; s.EncodeLoad = 1.2; return s; }
+    LoadSample Idle() { LoadSample s; s.EncodeLoad = 0.1; return s; }
+}
+
+TEST_CASE(GovernorNeedsSustainedPressure) {
+    LoadGovernor g(3);
+    int64_t t = 0;
+    for (; t < 900 * MS; t += 250 * MS) CHECK(!g.Update(Busy(), t));
+    CHECK_EQ(g.Level(), 0);
+    CHECK(g.Update(Busy(), t)); // 1 s of pressure
+    CHECK_EQ(g.Level(), 1);
+    // Cooldown: no second step for 2 s, however bad it gets
+    for (t += 250 * MS; t < 2750 * MS; t += 250 * MS) g.Update(Busy(), t);
+    CHECK_EQ(g.Level(), 1);
+    for (; t < 5000 * MS; t += 250 * MS) g.Update(Busy(), t);
+    CHECK_EQ(g.Level(), 2);
+    CHECK_EQ(g.Changes().size(), size_t(2));
+}
+
+TEST_CASE(GovernorDroppedFrameSkipsHold) {
+    LoadGovernor g(3);
+    LoadSample s; s.DroppedFrames = 1;
+    CHECK(g.Update(s, 0));
+    CHECK_EQ(g.Level(), 1);
+    s.DroppedFrames = 2;
+    CHECK(!g.Update(s, 500 * MS)); // Cooldown still applies
+    CHECK(!g.Update(s, 2000 * MS)); // Same count: no new drop, nothing to react to
+    CHECK_EQ(g.Level(), 1);
+    s.DroppedFrames = 3;
+    CHECK(g.Update(s, 2250 * MS));
+    CHECK_EQ(g.Level(), 2);
+}
+
+TEST_CASE(GovernorStepsDownAfterLongClearStretch) {
+    LoadGovernor g(3);
+    g.Update(LoadSample{ 0, 0, 0, 1 }, 0); // Level 1 via a lost frame
+    CHECK_EQ(g.Level(), 1);
+    int64_t t = 250 * MS;
+    LoadSample mid; mid.EncodeLoad = 0.7; // Neither pressure nor clear: stays
+    for (; t < 10000 * MS; t += 250 * MS) g.Update(mid, t);
+    CHECK_EQ(g.Level(), 1);
+    int64_t clear_from = t;
+    for (; t < clear_from + 4750 * MS; t += 250 * MS) g.Update(Idle(), t);
+    CHECK_EQ(g.Level(), 1);
+    for (; t < clear_from + 5250 * MS; t += 250 * MS) g.Update(Idle(), t);
+    CHECK_EQ(g.Level(), 0);
+}
+
+TEST_CASE(GovernorGapRestartsHold) {
+    LoadGovernor g(3);
+    g.Update(Busy(), 0);
+    g.Update(Busy(), 750 * MS);
+    g.Update(Busy(), 5000 * MS); // Not sampled for 4 s (paused): the hold starts over
+    CHECK_EQ(g.Level(), 0);
+    g.Update(Busy(), 6000 * MS);
+    CHECK_EQ(g.Level(), 1);
+}
+
+TEST_CASE(GovernorResetAndCap) {
+    LoadGovernor::Config c; c.UpHoldUs = 0; c.CooldownUs = 0;
+    LoadGovernor g(2, c);
+    for (int i = 0; i < 10; i++) g.Update(Busy(), i * 250 * MS);
+    CHECK_EQ(g.Level(), 2);
+    g.Reset(3000 * MS);
+    CHECK_EQ(g.Level(), 0);
+    CHECK_EQ(g.Changes().back().To, 0);
+    CHECK_EQ(g.Changes().back().From, 2);
+}
@@ -0,0 +1,51 @@
+#include "Check.hpp"
+#include "TestFrames.hpp"
+
+#include "core/MaskKernel.hpp"
+
+using RetroRec::Core::MosaicMask;
+using namespace retrorec::test;
+
+namespace {
+    // Every Block x Block cell of the rect (anchored at its top-left, clipped) holds one color: the cell's first pixel before masking.
+    template <int Block>
+    bool IsMosaic(const Pixels& before, const Pixels& after, int w, int h, int x, int y, int rw, int rh) {
+        const int x0 = std::max(x, 0), y0 = std::max(y, 0), x1 = std::min(x + rw, w), y1 = std::min(y + rh, h);
+        for (int py = 0; py < h; py++) {
+            for (int px = 0; px < w; px++) {
+                const size_t o = (static_cast<size_t>(py) * w + px) * 4;
+                const bool inside = px >= x0 && px < x1 && py >= y0 && py < y1;
+                size_t expect = o;
+                if (inside) expect = (static_cast<size_t>(y0 + (py - y0) / Block * Block) * w + x0 + (px - x0) / Block * Block) * 4;
+                if (memcmp(after.data() + o, before.data() + expect, 4) != 0) return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(MosaicCellsAreUniform) {
+    const int w = 64, h = 48;
+    Pixels before = NoiseFrame(w, h, 2), px = before;
+    MosaicMask<8>::Apply(px.data(), w, h, 5, 3, 30, 21);
+    CHECK(IsMosaic<8>(before, px, w, h, 5, 3, 30, 21));
+}
+
+TEST_CASE(MosaicClipsToFrame) {
+    const int w = 40, h = 30;
+    Pixels before = NoiseFrame(w, h, 5), px = before;
+    MosaicMask<15>::Apply(px.data(), w, h, -7, 20, 100, 100);
+    CHECK(IsMosaic<15>(before, px, w, h, -7, 20, 100, 100));
+    Pixels untouched = before;
+    MosaicMask<15>::Apply(untouched.data(), w, h, w + 5, 0, 10, 10); // Entirely outside
+    CHECK(untouched == before);
+}
+
+TEST_CASE(MosaicIsIdempotent) {
+    const int w = 48, h = 48;
+    Pixels px = NoiseFrame(w, h, 11);
+    MosaicMask<8>::Apply(px.data(), w, h, 4, 4, 33, 33);
+    Pixels once = px;
+    MosaicMask<8>::Apply(px.data(), w, h, 4, 4, 33, 33);
+    CHECK(px == once);
+}
@@ -0,0 +1,32 @@
+#include "Check.hpp"
+#include "TestFrames.hpp"
+
+#include "core/MotionTracker.hpp"
+
+using RetroRec::Core::MotionTracker;
+using RetroRec::Core::MotionVector;
+using namespace retrorec::test;
+
+TEST_CASE(TrackerStaticContent) {
+    const int w = 320, h = 240;
+    Pixels f = NoiseFrame(w, h, 3);
+    MotionVector v = MotionTracker().Track(f.data(), f.data(), w, h, 100, 80, 60, 20, {});
+    CHECK_EQ(v.dx, 0); CHECK_EQ(v.dy, 0);
+}
+
+// Page scrolled up by 30 px between `older` and `newer`: what is at y in the newer frame was at y + 30 before.
+TEST_CASE(TrackerFollowsScroll) {
+    const int w = 320, h = 240;
+    Pixels older = NoiseFrame(w, h, 4);
+    Pixels newer = Shifted(older, w, h, 0, -30, NoiseFrame(w, h, 5));
+    MotionVector v = MotionTracker().Track(newer.data(), older.data(), w, h, 100, 80, 60, 20, {});
+    CHECK_EQ(v.dx, 0); CHECK_EQ(v.dy, 30);
+}
+
+TEST_CASE(TrackerFollowsDiagonalMove) {
+    const int w = 320, h = 240;
+    Pixels older = BlockyFrame(w, h, 5, 6); // The coarse search steps by 4: it needs content that is not pure noise
+    Pixels newer = Shifted(older, w, h, 11, -7, BlockyFrame(w, h, 5, 8));
+    MotionVector v = MotionTracker().Track(newer.data(), older.data(), w, h, 120, 100, 48, 32, {});
+    CHECK_EQ(v.dx, -11); CHECK_EQ(v.dy, 7);
+}
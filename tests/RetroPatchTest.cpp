@@ -0,0 +1,131 @@
+// Retro patch of a written file (RetroPatcher::run) end to end: FFmpegSink writes a short recording with three GOPs, the
+// patcher masks a few frames of the middle one. Needs libx264; without it the sink cannot be prepared and the case is skipped.
+#include "Check.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "RecorderEngine.hpp"
+
+using namespace retrorec;
+
+namespace {
+    constexpr int W = 128, H = 96, FPS = 30, FRAMES = 30, GOP = 10;
+    constexpr int RX = 32, RY = 32, RW = 32, RH = 32; // The patched region: a fine checkerboard the mosaic flattens
+
+    // A gradient that moves every frame, and a 2 px checkerboard (its phase moving too) in the region. A keyframe every GOP frames.
+    AVFrameRef PatternFrame(int i) {
+        AVFrameRef f(av_frame_alloc(), [](AVFrame* p) { av_frame_free(&p); });
+        f->format = AV_PIX_FMT_YUV420P; f->width = W; f->height = H; av_frame_get_buffer(f.get(), 32);
+        for (int y = 0; y < H; y++)
+            for (int x = 0; x < W; x++) {
+                bool region = x >= RX && x < RX + RW && y >= RY && y < RY + RH;
+                f->data[0][y * f->linesize[0] + x] = region ? (((x + i) / 2 + y / 2) % 2 ? 215 : 40) : (uint8_t)(60 + (x + y + 3 * i) % 120);
+            }
+        for (int p = 1; p < 3; p++) for (int y = 0; y < H / 2; y++) memset(f->data[p] + y * f->linesize[p], 128, W / 2);
+        f->pts = ((int64_t)i * 1000000 + FPS - 1) / FPS; // Microseconds, rounded up so every frame lands in its own fps slot
+        f->pict_type = i % GOP == 0 ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+        return f;
+    }
+
+    struct Packet { std::vector<uint8_t> data; int64_t pts_us; bool key; };
+
+    std::vector<Packet> ReadPackets(const std::string& path, int stream) {
+        std::vector<Packet> out;
+        AVFormatContext* in = nullptr;
+        if (avformat_open_input(&in, path.c_str(), nullptr, nullptr) < 0) return out;
+        AVPacket* pkt = av_packet_alloc();
+        while (av_read_frame(in, pkt) >= 0) {
+            if (pkt->stream_index == stream)
+                out.push_back({ std::vector<uint8_t>(pkt->data, pkt->data + pkt->size), av_rescale_q(pkt->pts, in->streams[stream]->time_base, AVRational{ 1, 1000000 }), (pkt->flags & AV_PKT_FLAG_KEY) != 0 });
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+        avformat_close_input(&in);
+        return out;
+    }
+
+    // Mean distance of the region's luma from the mean of its 8x8 cell: ~0 for a mosaic, large for the checkerboard.
+    std::vector<double> RegionRoughness(const std::string& path, int stream) {
+        std::vector<double> out;
+        AVFormatContext* in = nullptr;
+        if (avformat_open_input(&in, path.c_str(), nullptr, nullptr) < 0 || avformat_find_stream_info(in, nullptr) < 0) { avformat_close_input(&in); return out; }
+        const AVCodec* dc = avcodec_find_decoder(AV_CODEC_ID_H264);
+        AVCodecContext* dec = avcodec_alloc_context3(dc);
+        avcodec_parameters_to_context(dec, in->streams[stream]->codecpar);
+        if (avcodec_open2(dec, dc, nullptr) < 0) { avcodec_free_context(&dec); avformat_close_input(&in); return out; }
+        AVPacket* pkt = av_packet_alloc();
+        AVFrame* f = av_frame_alloc();
+        auto receive = [&] {
+            while (avcodec_receive_frame(dec, f) == 0) {
+                double sum = 0;
+                for (int cy = RY; cy < RY + RH; cy += 8)
+                    for (int cx = RX; cx < RX + RW; cx += 8) {
+                        double mean = 0;
+                        for (int y = cy; y < cy + 8; y++) for (int x = cx; x < cx + 8; x++) mean += f->data[0][y * f->linesize[0] + x];
+                        mean /= 64;
+                        for (int y = cy; y < cy + 8; y++) for (int x = cx; x < cx + 8; x++) sum += std::fabs(f->data[0][y * f->linesize[0] + x] - mean);
+                    }
+                out.push_back(sum / (RW * RH));
+                av_frame_unref(f);
+            }
+        };
+        while (av_read_frame(in, pkt) >= 0) {
+            if (pkt->stream_index == stream && avcodec_send_packet(dec, pkt) >= 0) receive();
+            av_packet_unref(pkt);
+        }
+        avcodec_send_packet(dec, nullptr); receive();
+        av_frame_free(&f); av_packet_free(&pkt); avcodec_free_context(&dec); avformat_close_input(&in);
+        return out;
+    }
+}
+
+// Out-of-range GOPs come back bit-exact, the GOP holding the range is re-encoded with only the frames in range masked.
+TEST_CASE(RetroPatchMasksRangeAndCopiesOtherGops) {
+    const std::string path = (std::filesystem::temp_directory_path() / "retrorec_patch_test.mp4").string();
+    FFmpegSink sink;
+    Rendition r; r.file = path; r.fps = FPS;
+    if (!sink.prepare({ { "Synthetic", W, H } }, { r }, FPS)) { std::cout << "  (no H.264 encoder in this FFmpeg: skipped)" << std::endl; return; }
+    CHECK(sink.start(OutputLayout::FilePerSource, std::chrono::steady_clock::now(), 0));
+    for (int i = 0; i < FRAMES; i++) sink.push(0, PatternFrame(i));
+    sink.finish();
+    CHECK_EQ(sink.writtenTracks().size(), size_t(1));
+    if (sink.writtenTracks().size() != 1) return;
+    const WrittenTrack track = sink.writtenTracks()[0];
+
+    const std::vector<Packet> before = ReadPackets(path, track.stream_index);
+    CHECK_EQ(before.size(), size_t(FRAMES));
+    if (before.size() != (size_t)FRAMES) return;
+    for (int i = 0; i < FRAMES; i++) CHECK_EQ(before[i].key, i % GOP == 0);
+
+    // Frames 12..14: halfway between frame timestamps, so container rounding cannot move the edges
+    const int first = 12, last = 14;
+    PatchRegion region; region.stream_index = track.stream_index; region.cfg = track.cfg; region.threads = track.threads;
+    region.x = RX; region.y = RY; region.w = RW; region.h = RH;
+    RetroPatcher<MosaicMask<8>> patcher(path, (before[first - 1].pts_us + before[first].pts_us) / 2, (before[last].pts_us + before[last + 1].pts_us) / 2);
+    CHECK(patcher.run({ region }));
+    CHECK_EQ(patcher.statistics().gops, 3);
+    CHECK_EQ(patcher.statistics().gops_patched, 1);
+    CHECK_EQ(patcher.statistics().frames_reencoded, int64_t(GOP));
+
+    const std::vector<Packet> after = ReadPackets(path, track.stream_index);
+    CHECK_EQ(after.size(), size_t(FRAMES));
+    if (after.size() != (size_t)FRAMES) return;
+    for (int i = 0; i < FRAMES; i++) {
+        CHECK_EQ(after[i].pts_us, before[i].pts_us);
+        CHECK_EQ(after[i].key, before[i].key);
+        if (i / GOP != first / GOP) CHECK(after[i].data == before[i].data); // Copied GOPs: bit-exact
+    }
+
+    const std::vector<double> rough = RegionRoughness(path, track.stream_index);
+    CHECK_EQ(rough.size(), size_t(FRAMES));
+    for (size_t i = 0; i < rough.size(); i++) {
+        const bool masked = (int)i >= first && (int)i <= last;
+        if (masked) CHECK(rough[i] < 8);
+        else CHECK(rough[i] > 30);
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
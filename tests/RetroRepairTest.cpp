@@ -0,0 +1,166 @@
+// Retro repairs against repeated frames (frames sharing their pixels with the frame before them), and while Stop drains the ring.
+#include "Check.hpp"
+#include "EngineFixtures.hpp"
+
+#include <atomic>
+#include <condition_variable>
+
+using namespace retrorec;
+using namespace retrorec::test;
+using RetroRec::Core::FramePool;
+using RetroRec::Core::RingBuffer;
+using RetroRec::Core::MotionTracker;
+
+namespace {
+    using CaptureEngine = BasicRecorderEngine<HeadlessPlatform, Bgra, MosaicMask<8>, CaptureSink>;
+
+    bool PixelsAreMosaic(const uint8_t* p, int w, int rx, int ry, int rw, int rh, int cell) {
+        for (int cy = ry; cy < ry + rh; cy += cell)
+            for (int cx = rx; cx < rx + rw; cx += cell)
+                for (int py = cy; py < std::min(cy + cell, ry + rh); py++)
+                    for (int px = cx; px < std::min(cx + cell, rx + rw); px++)
+                        if (memcmp(p + (static_cast<size_t>(py) * w + px) * 4, p + (static_cast<size_t>(cy) * w + cx) * 4, 4) != 0) return false;
+        return true;
+    }
+}
+
+// The last converted frame shares its pixels with the repeats still in the ring. A retro repair masks those pixels;
+// every frame converted afterwards must show the mask, although their capture-time diffs found nothing.
+TEST_CASE(RepairOfRepeatsReachesTheEncoder) {
+    const int w = 128, h = 96;
+    CaptureEngine e;
+    auto owned = std::make_unique<ScriptedSource>(w, h);
+    ScriptedSource& src = *owned;
+    CHECK(e.addSource(std::move(owned)));
+    e.setSensitiveDetection(false);
+    e.setHistoryBudget(0, 0.1); // Minimum window: 3 frames
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+
+    src.Show(NoiseFrame(w, h, 21)); src.MoveCursor(5, 5); Tick(e);
+    for (int k = 1; k <= 5; k++) { src.MoveCursor(5 + k, 5); Tick(e); } // Only the cursor moves: repeats
+    CHECK(e.getSink().WaitFor(3)); // The original and two repeats were converted; three repeats are in the ring
+
+    e.addMosaic(16, 16, 48, 32);
+    e.applyRetroactiveMosaic();
+    for (int k = 0; k < 3; k++) { src.MoveCursor(20 + k, 5); Tick(e); }
+    e.stopRecording();
+
+    const CaptureSink& sink = e.getSink();
+    CHECK_EQ(sink.Count(), size_t(9));
+    CHECK(!LumaIsMosaic(sink.Luma(0), w, 16, 16, 48, 32, 8));
+    for (size_t i = 3; i < sink.Count(); i++) {
+        if (!LumaIsMosaic(sink.Luma(i), w, 16, 16, 48, 32, 8)) { std::cerr << "frame " << i << " leaks the masked area" << std::endl; CHECK(false); }
+    }
+}
+
+// Page scrolled by 30 px, then only the cursor moved (a repeat). Tracking must match the repeat's pixels against the
+// frame before the scroll BEFORE they are masked, or the mask stays where it was drawn.
+TEST_CASE(TrackedRepairThroughRepeat) {
+    const int w = 160, h = 120, x = 40, y = 20, rw = 40, rh = 24;
+    FramePool pool(w, h);
+    Pixels newer = BlockyFrame(w, h, 5, 31);
+    Pixels older = Shifted(newer, w, h, 0, 30, BlockyFrame(w, h, 5, 32)); // What is at y now was at y + 30
+    auto f0 = pool.Acquire(); memcpy(f0->Data(), older.data(), older.size());
+    auto f1 = pool.Acquire(); memcpy(f1->Data(), newer.data(), newer.size());
+    auto rep = pool.Repeat(*f1);
+    CHECK(rep && rep->Data() == f1->Data());
+    RingBuffer ring(size_t(10));
+    uint64_t seq = 1;
+    for (auto& f : { f0, f1, rep }) { f->Sequence = seq; f->Timestamp = static_cast<int64_t>(seq) * 33333; seq++; ring.Push(f); }
+
+    ring.ApplyTrackedRetroactiveMask(seq, x, y, rw, rh, MotionTracker(), [&](uint8_t* d, int fw, int fh, int dx, int dy) { MosaicMask<8>::Apply(d, fw, fh, x + dx, y + dy, rw, rh); });
+
+    CHECK_EQ(rep->Masked.size(), size_t(1));
+    CHECK_EQ(f1->Masked.size(), size_t(1));
+    CHECK_EQ(f0->Masked.size(), size_t(1));
+    if (f0->Masked.size() == 1) { CHECK_EQ(f0->Masked[0].X, x); CHECK_EQ(f0->Masked[0].Y, y + 30); }
+    CHECK(PixelsAreMosaic(f1->Data(), w, x, y, rw, rh, 8));
+    CHECK(PixelsAreMosaic(f0->Data(), w, x, y + 30, rw, rh, 8));
+}
+
+// A drag adds its squares over several ticks; one repair job covers them all. Frames captured between the first and
+// the last square only have the early squares live, so the retro pass must reach up to the newest square's anchor.
+TEST_CASE(RepairJobStartsFromItsNewestSquare) {
+    const int w = 128, h = 96;
+    CaptureEngine e;
+    auto owned = std::make_unique<ScriptedSource>(w, h);
+    ScriptedSource& src = *owned;
+    CHECK(e.addSource(std::move(owned)));
+    e.setSensitiveDetection(false);
+    e.setHistoryBudget(0, 1.0);
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+
+    const Pixels page = NoiseFrame(w, h, 7);
+    for (int k = 0; k < 4; k++) { src.Show(page); Tick(e); }
+    e.addMosaic(16, 16, 32, 32);
+    for (int k = 0; k < 3; k++) { src.Show(page); Tick(e); }
+    e.addMosaic(48, 16, 32, 32); // Touches the first square: same job
+    e.applyRetroactiveMosaic();
+    for (int k = 0; k < 2; k++) { src.Show(page); Tick(e); }
+    e.stopRecording();
+
+    const CaptureSink& sink = e.getSink();
+    CHECK_EQ(sink.Count(), size_t(9));
+    for (size_t i = 0; i < sink.Count(); i++) {
+        if (!LumaIsMosaic(sink.Luma(i), w, 16, 16, 64, 32, 8)) { std::cerr << "frame " << i << " misses a square" << std::endl; CHECK(false); }
+    }
+}
+
+namespace {
+    // Holds the worker inside push() once `hold` is set, after keeping the frame, until Release().
+    class GatedSink : public CaptureSink {
+        std::mutex gate_mutex;
+        std::condition_variable gate;
+        bool held = false, released = false;
+    public:
+        std::atomic<bool> hold{false};
+        void push(size_t s, const AVFrameRef& yuv) {
+            CaptureSink::push(s, yuv);
+            if (!hold) return;
+            std::unique_lock<std::mutex> l(gate_mutex);
+            held = true; gate.notify_all();
+            gate.wait(l, [&] { return released; });
+        }
+        bool WaitHeld() { std::unique_lock<std::mutex> l(gate_mutex); return gate.wait_for(l, std::chrono::seconds(2), [&] { return held; }); }
+        void Release() { { std::lock_guard<std::mutex> l(gate_mutex); released = true; } gate.notify_all(); }
+    };
+}
+
+// A zone drawn while Stop writes out the ring must reach every frame not yet written, not wait for the drain to finish.
+TEST_CASE(RepairDuringStopReachesTheRestOfTheRing) {
+    const int w = 128, h = 96;
+    BasicRecorderEngine<HeadlessPlatform, Bgra, MosaicMask<8>, GatedSink> e;
+    auto owned = std::make_unique<ScriptedSource>(w, h);
+    ScriptedSource& src = *owned;
+    CHECK(e.addSource(std::move(owned)));
+    e.setSensitiveDetection(false);
+    e.setRetroTracking(false);
+    e.setHistoryBudget(0, 1.0); // Everything below stays in the ring until Stop
+    CHECK(e.initialize());
+    CHECK(e.arm());
+    e.setPreRoll(0);
+    CHECK(e.startRecording());
+    for (uint32_t k = 0; k < 6; k++) { src.Show(NoiseFrame(w, h, 40 + k)); Tick(e); }
+    CHECK_EQ(e.getSink().Count(), size_t(0));
+
+    e.getSink().hold = true;
+    std::thread stopper([&] { e.stopRecording(); });
+    CHECK(e.getSink().WaitHeld()); // The first frame of the drain is out, five are still in the ring
+    e.addMosaic(16, 16, 48, 32);
+    e.applyRetroactiveMosaic();
+    e.getSink().Release();
+    stopper.join();
+
+    const GatedSink& sink = e.getSink();
+    CHECK_EQ(sink.Count(), size_t(6));
+    if (sink.Count() > 0) CHECK(!LumaIsMosaic(sink.Luma(0), w, 16, 16, 48, 32, 8));
+    for (size_t i = 1; i < sink.Count(); i++) {
+        if (!LumaIsMosaic(sink.Luma(i), w, 16, 16, 48, 32, 8)) { std::cerr << "frame " << i << " left the drain unmasked" << std::endl; CHECK(false); }
+    }
+}
@@ -0,0 +1,55 @@
+// Frame fixtures shared by the tests: tightly packed 4-byte pixels, deterministic content.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace retrorec::test {
+
+    using Pixels = std::vector<uint8_t>;
+
+    // Deterministic noise (xorshift), alpha 255. Textured enough for block matching to lock on.
+    inline Pixels NoiseFrame(int w, int h, uint32_t seed = 1) {
+        Pixels p(static_cast<size_t>(w) * h * 4);
+        uint32_t s = seed * 2654435761u + 1;
+        for (size_t i = 0; i < p.size(); i++) {
+            if ((i & 3) == 3) { p[i] = 255; continue; }
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            p[i] = static_cast<uint8_t>(s);
+        }
+        return p;
+    }
+
+    // Noise in `cell` x `cell` blocks: screen-like content, a near miss still matches most pixels.
+    inline Pixels BlockyFrame(int w, int h, int cell, uint32_t seed = 1) {
+        Pixels n = NoiseFrame((w + cell - 1) / cell, (h + cell - 1) / cell, seed), p(static_cast<size_t>(w) * h * 4);
+        const int nw = (w + cell - 1) / cell;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) memcpy(p.data() + (static_cast<size_t>(y) * w + x) * 4, n.data() + (static_cast<size_t>(y / cell) * nw + x / cell) * 4, 4);
+        return p;
+    }
+
+    inline Pixels SolidFrame(int w, int h, uint8_t c0, uint8_t c1, uint8_t c2) {
+        Pixels p(static_cast<size_t>(w) * h * 4);
+        for (size_t i = 0; i < p.size(); i += 4) { p[i] = c0; p[i + 1] = c1; p[i + 2] = c2; p[i + 3] = 255; }
+        return p;
+    }
+
+    inline uint8_t* PixelAt(Pixels& p, int w, int x, int y) { return p.data() + (static_cast<size_t>(y) * w + x) * 4; }
+
+    // `src` moved by (dx, dy); uncovered pixels keep `fill`'s content.
+    inline Pixels Shifted(const Pixels& src, int w, int h, int dx, int dy, const Pixels& fill) {
+        Pixels out = fill;
+        for (int y = 0; y < h; y++) {
+            const int sy = y - dy;
+            if (sy < 0 || sy >= h) continue;
+            for (int x = 0; x < w; x++) {
+                const int sx = x - dx;
+                if (sx < 0 || sx >= w) continue;
+                memcpy(out.data() + (static_cast<size_t>(y) * w + x) * 4, src.data() + (static_cast<size_t>(sy) * w + sx) * 4, 4);
+            }
+        }
+        return out;
+    }
+}
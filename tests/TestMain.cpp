@@ -0,0 +1,3 @@
+#include "Check.hpp"
+
+int main(int argc, char** argv) { return retrorec::test::RunAll(argc, argv); }
@@ -0,0 +1,63 @@
+#include "Check.hpp"
+#include "TestFrames.hpp"
+
+#include "core/Thumbnail.hpp"
+
+using RetroRec::Core::Downscale4x;
+using RetroRec::Core::ThumbnailChain;
+using namespace retrorec::test;
+
+namespace {
+    // Reference: same rounding as the SIMD path (pairwise averages of pairwise averages)
+    Pixels Reference(const Pixels& src, int w, int h) {
+        auto avg = [](int a, int b) { return (a + b + 1) >> 1; };
+        const int dw = w / 4, dh = h / 4;
+        Pixels out(static_cast<size_t>(dw) * dh * 4);
+        for (int y = 0; y < dh; y++) for (int x = 0; x < dw; x++) for (int c = 0; c < 4; c++) {
+            int col[4];
+            for (int k = 0; k < 4; k++) {
+                auto at = [&](int r) { return int(src[(static_cast<size_t>(y * 4 + r) * w + x * 4 + k) * 4 + c]); };
+                col[k] = avg(avg(at(0), at(1)), avg(at(2), at(3)));
+            }
+            out[(static_cast<size_t>(y) * dw + x) * 4 + c] = static_cast<uint8_t>(avg(avg(col[0], col[1]), avg(col[2], col[3])));
+        }
+        return out;
+    }
+}
+
+TEST_CASE(DownscaleMatchesReference) {
+    const int sizes[][2] = { { 64, 32 }, { 78, 22 }, { 1282, 14 }, { 4, 4 } }; // Widths that leave a scalar tail
+    for (const auto& s : sizes) {
+        const int w = s[0], h = s[1];
+        Pixels src = NoiseFrame(w, h, w), out(static_cast<size_t>(w / 4) * (h / 4) * 4);
+        Downscale4x(src.data(), w, h, static_cast<size_t>(w) * 4, out.data(), static_cast<size_t>(w / 4) * 4);
+        CHECK(out == Reference(src, w, h));
+    }
+}
+
+TEST_CASE(ChainCachesUntilInvalidated) {
+    const int w = 128, h = 64;
+    Pixels px = NoiseFrame(w, h, 9);
+    ThumbnailChain chain;
+    auto s1 = chain.Get(ThumbnailChain::Sixteenth, px.data(), w, h);
+    CHECK(s1 && s1->Width == 8 && s1->Height == 4);
+    CHECK(chain.Get(ThumbnailChain::Sixteenth, px.data(), w, h) == s1);
+    // A strip keeps only the 1/16: the 1/4 is rebuilt when previewed
+    auto q1 = chain.Get(ThumbnailChain::Quarter, px.data(), w, h);
+    CHECK(q1 && q1->Width == 32 && q1->Height == 16);
+    CHECK(chain.Get(ThumbnailChain::Quarter, px.data(), w, h) == q1);
+
+    px.assign(px.size(), 0); // Retro repair
+    chain.Invalidate();
+    auto s2 = chain.Get(ThumbnailChain::Sixteenth, px.data(), w, h);
+    CHECK(s2 != s1);
+    CHECK(s2->Pixels == Pixels(s2->Pixels.size(), 0));
+    CHECK(s1->Pixels != s2->Pixels); // Handed out thumbnails stay as they were
+}
+
+TEST_CASE(ChainTooSmall) {
+    Pixels px = NoiseFrame(8, 8);
+    ThumbnailChain chain;
+    CHECK(chain.Get(ThumbnailChain::Quarter, px.data(), 8, 8) != nullptr);
+    CHECK(chain.Get(ThumbnailChain::Sixteenth, px.data(), 8, 8) == nullptr);
+}
@@ -0,0 +1,49 @@
+#include "Check.hpp"
+#include "TestFrames.hpp"
+
+#include "core/TileMap.hpp"
+
+using RetroRec::Core::TileMap;
+using namespace retrorec::test;
+
+TEST_CASE(TileMapDiffMarksOnlyChangedTiles) {
+    const int w = 100, h = 70; // 4 x 3 tiles of 32, edge tiles smaller
+    Pixels a = NoiseFrame(w, h), b = a;
+    PixelAt(b, w, 40, 40)[1] ^= 0xFF; // Tile (1, 1)
+    PixelAt(b, w, 99, 69)[0] ^= 0xFF; // Bottom-right edge tile (3, 2)
+    TileMap m(w, h, 32);
+    CHECK_EQ(m.Cols(), 4); CHECK_EQ(m.Rows(), 3);
+    m.Diff(a.data(), b.data());
+    CHECK_EQ(m.Count(), size_t(2));
+    CHECK(m.IsSet(1, 1));
+    CHECK(m.IsSet(3, 2));
+}
+
+TEST_CASE(TileMapDiffOfSamePointerMarksNothing) {
+    Pixels a = NoiseFrame(64, 64);
+    TileMap m(64, 64, 16);
+    m.Diff(a.data(), a.data());
+    CHECK_EQ(m.Count(), size_t(0));
+}
+
+TEST_CASE(TileMapMarkRectClipsToFrame) {
+    TileMap m(100, 70, 32);
+    m.MarkRect(-50, -50, 60, 60); // Only (0, 0) is inside
+    CHECK_EQ(m.Count(), size_t(1));
+    m.MarkRect(97, 65, 500, 500); // Only the edge tile (3, 2)
+    CHECK(m.IsSet(3, 2));
+    CHECK_EQ(m.Count(), size_t(2));
+    int x, y, tw, th; m.TileRect(3, 2, x, y, tw, th);
+    CHECK_EQ(x, 96); CHECK_EQ(y, 64); CHECK_EQ(tw, 4); CHECK_EQ(th, 6);
+}
+
+TEST_CASE(TileMapMergeAndClear) {
+    TileMap a(64, 64, 16), b(64, 64, 16);
+    a.Mark(0, 0); b.Mark(3, 3); b.Mark(0, 0);
+    a.Merge(b);
+    CHECK_EQ(a.Count(), size_t(2));
+    a.Clear();
+    CHECK_EQ(a.Count(), size_t(0));
+    a.MarkAll();
+    CHECK_EQ(a.Count(), size_t(16));
+}